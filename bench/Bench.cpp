@@ -0,0 +1,36 @@
+/*
+ * Bench.cpp
+ *
+ *  Created on: 14 Oct 2026
+ */
+
+#include "Bench.h"
+#include <General/SafeVsnprintf.h>
+
+namespace Bench
+{
+	void RunAll(OutputFunction output, bool quick) noexcept
+	{
+		const uint32_t iterations = (quick) ? 1000 : 100000;
+		char line[80];
+		SafeSnprintf(line, sizeof(line), "RRFLibraries benchmarks, %u iterations, times are %s per operation", (unsigned int)iterations, TimeUnits);
+		output(line);
+		RunFormatting(output, iterations);
+		RunParsing(output, iterations);
+		RunContainers(output, iterations);
+		RunMaths(output, iterations);
+	}
+
+	void Report(OutputFunction output, const char *name, Time timePerCall) noexcept
+	{
+		char line[80];
+#ifdef __arm__
+		SafeSnprintf(line, sizeof(line), "%-44s %8u", name, (unsigned int)timePerCall);
+#else
+		SafeSnprintf(line, sizeof(line), "%-44s %8.1f", name, (double)timePerCall);
+#endif
+		output(line);
+	}
+}
+
+// End
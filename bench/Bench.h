@@ -0,0 +1,130 @@
+/*
+ * Bench.h
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Benchmarks for the hot paths in RRFLibraries.
+ *  On the host the results are in nanoseconds per operation. On the target they are in CPU cycles per operation, measured using the DWT cycle counter or on the SAMC21 using SysTick.
+ */
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __arm__
+# include <RTOSIface/RTOSIface.h>
+# include <RTOSIface/CycleTimer.h>
+#else
+# include <chrono>
+#endif
+
+namespace Bench
+{
+	// Function that the benchmarks call to output each line of the report. The line doesn't include a newline character.
+	typedef void (*OutputFunction)(const char *line) noexcept;
+
+	// Run all the benchmarks, passing the report to 'output' a line at a time.
+	// This is the entry point for both the host program and firmware that runs the benchmarks on the target.
+	// If quick is true then fewer iterations are used, so that the run finishes quickly but the results are less accurate.
+	void RunAll(OutputFunction output, bool quick = false) noexcept;
+
+	// Check that all the integer square root functions return exact results, returning true if they do.
+	// The exhaustive check tests every 32-bit input and 50 million 62-bit ones, which takes minutes on the host. The other check takes about 1/1000 of the time.
+	bool CheckIsqrt(OutputFunction output, bool exhaustive) noexcept;
+
+	// Check that GCodeFieldScanner splits lines into the correct fields, returning true if it does
+	bool CheckGCodeFieldScanner(OutputFunction output) noexcept;
+
+	// Stop the compiler optimising away a value that a benchmark computes
+	template<class T> inline void KeepValue(const T& val) noexcept
+	{
+		__asm volatile("" : : "r,m" (val) : "memory");
+	}
+
+#ifdef __arm__
+
+	typedef uint32_t Time;
+	constexpr const char *TimeUnits = "cycles";
+
+# if RRFLIBS_SAMC21
+
+	// The M0+ doesn't have a cycle counter, so we time each call using SysTick, which counts down at the CPU clock rate and is reloaded at every RTOS tick.
+	// This only works if each call takes less than one tick. Calls that are interrupted by the tick interrupt include the time taken by it.
+	template<class F> inline Time TimePerCall(F func, uint32_t iterations) noexcept
+	{
+		volatile uint32_t * const sysTickReload = reinterpret_cast<volatile uint32_t *>(0xE000E014);
+		volatile uint32_t * const sysTickValue = reinterpret_cast<volatile uint32_t *>(0xE000E018);
+		const uint32_t period = *sysTickReload + 1;
+		uint64_t total = 0, overhead = 0;
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			uint32_t startTime = *sysTickValue;
+			__asm volatile("" : : : "memory");
+			uint32_t endTime = *sysTickValue;
+			overhead += (startTime >= endTime) ? startTime - endTime : startTime + period - endTime;
+
+			startTime = *sysTickValue;
+			func();
+			__asm volatile("" : : : "memory");
+			endTime = *sysTickValue;
+			total += (startTime >= endTime) ? startTime - endTime : startTime + period - endTime;
+		}
+		return (iterations != 0 && total > overhead) ? (Time)((total - overhead)/iterations) : 0;
+	}
+
+# else
+
+	// Measure the mean time per call of a function or lambda that takes no arguments
+	template<class F> inline Time TimePerCall(F func, uint32_t iterations) noexcept
+	{
+		return MeasureCyclesPerCall(func, iterations);
+	}
+
+# endif
+
+#else
+
+	typedef float Time;
+	constexpr const char *TimeUnits = "ns";
+
+	template<class F> inline Time TimePerCall(F func, uint32_t iterations) noexcept
+	{
+		if (iterations == 0)
+		{
+			return 0.0;
+		}
+
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point startTime = Clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			__asm volatile("" : : : "memory");
+		}
+		const auto overhead = Clock::now() - startTime;
+
+		startTime = Clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			func();
+			__asm volatile("" : : : "memory");
+		}
+		const auto total = Clock::now() - startTime;
+		const float ns = (float)std::chrono::duration_cast<std::chrono::nanoseconds>(total - overhead).count();
+		return (ns > 0.0) ? ns/(float)iterations : 0.0;
+	}
+
+#endif
+
+	// Benchmark groups, one per source file in the bench directory
+	void RunFormatting(OutputFunction output, uint32_t iterations) noexcept;
+	void RunParsing(OutputFunction output, uint32_t iterations) noexcept;
+	void RunContainers(OutputFunction output, uint32_t iterations) noexcept;
+	void RunMaths(OutputFunction output, uint32_t iterations) noexcept;
+
+	// Report the result of one benchmark
+	void Report(OutputFunction output, const char *name, Time timePerCall) noexcept;
+}
+
+#endif /* BENCH_BENCH_H_ */
@@ -0,0 +1,76 @@
+/*
+ * BenchContainers.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Benchmarks for RingBuffer and Freelist
+ */
+
+#include "Bench.h"
+#include <General/RingBuffer.h>
+#include <General/FreelistManager.h>
+
+namespace Bench
+{
+	constexpr size_t BlockSize = 64;
+
+	// Dummy class of a typical size for objects allocated from freelists
+	struct BenchObject
+	{
+		uint32_t data[6];
+	};
+
+	void RunContainers(OutputFunction output, uint32_t iterations) noexcept
+	{
+		static RingBuffer<char, 256> ringBuffer;
+		char block[BlockSize];
+		for (size_t i = 0; i < BlockSize; ++i)
+		{
+			block[i] = (char)('A' + (i % 26));
+		}
+
+		// The put and get pointers move round the buffer, so some of the blocks are split
+		Report(output, "RingBuffer PutBlock+GetBlock, 64 chars", TimePerCall([&block]() noexcept
+			{
+				KeepValue(ringBuffer.PutBlock(block, BlockSize));
+				KeepValue(ringBuffer.GetBlock(block, BlockSize));
+			}, iterations));
+
+		Report(output, "RingBuffer PutItem+GetItem x64", TimePerCall([&block]() noexcept
+			{
+				for (size_t i = 0; i < BlockSize; ++i)
+				{
+					(void)ringBuffer.PutItem(block[i]);
+				}
+				for (size_t i = 0; i < BlockSize; ++i)
+				{
+					(void)ringBuffer.GetItem(block[i]);
+				}
+			}, iterations));
+
+		// Reserve enough objects first so that we measure the freelist and not the heap
+		FreelistManager::Reserve<BenchObject>(4);
+		Report(output, "Freelist Allocate+Release", TimePerCall([]() noexcept
+			{
+				void * const p = FreelistManager::Allocate<BenchObject>();
+				KeepValue(p);
+				FreelistManager::Release<BenchObject>(p);
+			}, iterations));
+
+		Report(output, "Freelist Allocate x4 + Release x4", TimePerCall([]() noexcept
+			{
+				void *p[4];
+				for (void *& q : p)
+				{
+					q = FreelistManager::Allocate<BenchObject>();
+				}
+				KeepValue(p);
+				for (void *q : p)
+				{
+					FreelistManager::Release<BenchObject>(q);
+				}
+			}, iterations));
+	}
+}
+
+// End
@@ -0,0 +1,94 @@
+/*
+ * BenchFormatting.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Benchmarks for SafeSnprintf and StringRef
+ */
+
+#include "Bench.h"
+#include <General/SafeVsnprintf.h>
+#include <General/StringRef.h>
+
+namespace Bench
+{
+	// Values to format. We cycle through these so that the compiler can't evaluate the results at compile time.
+	static const int32_t intValues[8] = { 0, 7, -42, 1234, -98765, 2000000000, -2147483647, 65535 };
+	static const float floatValues[8] = { 0.0, 1.5, -12.345, 123.456, -0.001, 9999.99, 3.14159, -250.0 };
+	static const char * const stringValues[8] = { "X", "Y", "Z", "E0", "heater", "fan", "0:/sys/config.g", "" };
+
+	// 64-bit values for %llu, of typical sizes for byte counts, times in microseconds and the largest possible value
+	static const uint64_t u64Values[8] = { 0, 1234, 4294967295u, 4294967296u, 123456789012u, 98765432109876ull, 1844674407370955161ull, 18446744073709551615ull };
+
+	// How SafeVsnprintf converted integers before it used two-digit tables and 64-bit values split into 32-bit chunks: one 64-bit division by the base per digit.
+	// The base isn't a compile-time constant, so on processors without a 64-bit divide instruction each digit costs a call to the division library function.
+	// The reference benchmark passes the result to SafeSnprintf as a string, so comparing it with SafeSnprintf %llu shows the gain on each processor.
+	static volatile unsigned int referenceBase = 10;
+
+	static int ReferenceFormatU64(char *buf, size_t maxLen, uint64_t u) noexcept
+	{
+		const unsigned int base = referenceBase;
+		char printBuf[22];
+		char *s = printBuf + sizeof(printBuf);
+		*--s = 0;
+		do
+		{
+			const unsigned int t = (unsigned int)(u % base);
+			u /= base;
+			*--s = (char)(t + '0');
+		} while (u != 0);
+		return SafeSnprintf(buf, maxLen, "%s", s);
+	}
+
+	void RunFormatting(OutputFunction output, uint32_t iterations) noexcept
+	{
+		char buf[100];
+		unsigned int n = 0;
+
+		Report(output, "SafeSnprintf %d", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "%d", (int)intValues[n++ & 7]));
+			}, iterations));
+
+		Report(output, "SafeSnprintf %u", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "%u", (unsigned int)intValues[n++ & 7]));
+			}, iterations));
+
+		Report(output, "SafeSnprintf %llu", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "%llu", (unsigned long long)u64Values[n++ & 7]));
+			}, iterations));
+
+		Report(output, "reference %llu, one division per digit", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(ReferenceFormatU64(buf, sizeof(buf), u64Values[n++ & 7]));
+			}, iterations));
+
+		Report(output, "SafeSnprintf %.3f", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "%.3f", (double)floatValues[n++ & 7]));
+			}, iterations));
+
+		Report(output, "SafeSnprintf X%.3f Y%.3f Z%.3f", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "X%.3f Y%.3f Z%.3f", (double)floatValues[n & 7], (double)floatValues[(n + 1) & 7], (double)floatValues[(n + 2) & 7]));
+				++n;
+			}, iterations));
+
+		Report(output, "SafeSnprintf %s", TimePerCall([&buf, &n]() noexcept
+			{
+				KeepValue(SafeSnprintf(buf, sizeof(buf), "%s", stringValues[n++ & 7]));
+			}, iterations));
+
+		Report(output, "StringRef::catf %s=%d", TimePerCall([&buf, &n]() noexcept
+			{
+				const StringRef ref(buf, sizeof(buf));
+				ref.copy("M106 ");
+				KeepValue(ref.catf("%s=%d", stringValues[n & 7], (int)intValues[n & 7]));
+				++n;
+			}, iterations));
+	}
+}
+
+// End
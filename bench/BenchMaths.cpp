@@ -0,0 +1,55 @@
+/*
+ * BenchMaths.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Benchmarks for the integer square root functions. The FPU variants are only worth using on processors with a FPU.
+ */
+
+#include "Bench.h"
+#include <Math/Isqrt.h>
+
+namespace Bench
+{
+	// Typical inputs from the motion planner, which are mostly larger than 32 bits
+	static const uint64_t values64[8] = { 0x0000000000012345, 0x00000000FFFFFFFF, 0x0000000123456789, 0x0000123456789ABC,
+										  0x00FEDCBA98765432, 0x3FFFFFFFFFFFFFFF, 0x0000000000000000, 0x0000004000000000 };
+	static const uint32_t values32[8] = { 0x00000003, 0x00000400, 0x00012345, 0x00FFFFFF, 0x12345678, 0xFFFFFFFF, 0x0000001F, 0x80000000 };
+
+	void RunMaths(OutputFunction output, uint32_t iterations) noexcept
+	{
+		unsigned int n = 0;
+
+		Report(output, "isqrt64", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt64(values64[n++ & 7]));
+			}, iterations));
+
+		Report(output, "isqrt64Fpu", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt64Fpu(values64[n++ & 7]));
+			}, iterations));
+
+		Report(output, "isqrt64, 32-bit inputs", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt64(values32[n++ & 7]));
+			}, iterations));
+
+		Report(output, "isqrt32", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt32(values32[n++ & 7]));
+			}, iterations));
+
+		Report(output, "isqrt32Normalised", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt32Normalised(values32[n++ & 7]));
+			}, iterations));
+
+		Report(output, "isqrt32Fpu", TimePerCall([&n]() noexcept
+			{
+				KeepValue(isqrt32Fpu(values32[n++ & 7]));
+			}, iterations));
+	}
+}
+
+// End
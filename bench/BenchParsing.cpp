@@ -0,0 +1,97 @@
+/*
+ * BenchParsing.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Benchmarks for NumericConverter, SafeStrtof and NamedEnum lookup
+ */
+
+#include "Bench.h"
+#include <General/NumericConverter.h>
+#include <General/SafeStrtod.h>
+#include <General/NamedEnum.h>
+#include <cstring>
+#include <functional>
+
+namespace Bench
+{
+	static const char * const numberStrings[8] = { "0", "12", "-3.5", "123.456", "1000000", "-0.0125", "2.5e3", "65535" };
+
+	NamedEnum(BenchKeyword, uint8_t, axis, display, endstop, extruder, fan, heater, network, probe, sensor, tool);
+
+	// The same names in alphabetical order, for NamedEnumLookup
+	static const char * const keywordNames[] = { "axis", "display", "endstop", "extruder", "fan", "heater", "network", "probe", "sensor", "tool" };
+	static_assert(sizeof(keywordNames)/sizeof(keywordNames[0]) == BenchKeyword::NumValues, "Keyword tables don't match");
+
+	// Keywords to look up, including one that isn't there. The mixed case ones are for the lookups that ignore case.
+	static const char * const keywords[8] = { "heater", "fan", "tool", "probe", "axis", "sensor", "unknown", "network" };
+	static const char * const mixedCaseKeywords[8] = { "Heater", "FAN", "tool", "Probe", "aXis", "SENSOR", "Unknown", "Network" };
+
+	void RunParsing(OutputFunction output, uint32_t iterations) noexcept
+	{
+		unsigned int n = 0;
+
+		Report(output, "NumericConverter::Accumulate+GetFloat", TimePerCall([&n]() noexcept
+			{
+				const char *s = numberStrings[n++ & 7];
+				NumericConverter conv;
+				if (conv.Accumulate(*s, true, true, [&s]() noexcept -> char { return *++s; }))
+				{
+					KeepValue(conv.GetFloat());
+				}
+			}, iterations));
+
+		// The same again but passing a std::function (also followed by GetFloat), which is how Accumulate used to be called, for comparison with the template version above
+		Report(output, "NumericConverter::Accumulate(std::function)", TimePerCall([&n]() noexcept
+			{
+				const char *s = numberStrings[n++ & 7];
+				NumericConverter conv;
+				const std::function<char()> nextChar = [&s]() noexcept -> char { return *++s; };
+				if (conv.Accumulate(*s, true, true, nextChar))
+				{
+					KeepValue(conv.GetFloat());
+				}
+			}, iterations));
+
+		Report(output, "NumericConverter::Accumulate(span)+GetFloat", TimePerCall([&n]() noexcept
+			{
+				const char * const s = numberStrings[n++ & 7];
+				NumericConverter conv;
+				size_t charsConsumed;
+				if (conv.Accumulate(s, strlen(s), true, true, charsConsumed))
+				{
+					KeepValue(conv.GetFloat());
+				}
+			}, iterations));
+
+		Report(output, "SafeStrtof", TimePerCall([&n]() noexcept
+			{
+				KeepValue(SafeStrtof(numberStrings[n++ & 7]));
+			}, iterations));
+
+		Report(output, "StrToI32", TimePerCall([&n]() noexcept
+			{
+				KeepValue(StrToI32(numberStrings[n++ & 7]));
+			}, iterations));
+
+		Report(output, "NamedEnumLookup (binary search)", TimePerCall([&n]() noexcept
+			{
+				KeepValue(NamedEnumLookup(keywords[n++ & 7], keywordNames, BenchKeyword::NumValues));
+			}, iterations));
+
+		Report(output, "NamedEnum from string (hash)", TimePerCall([&n]() noexcept
+			{
+				const BenchKeyword k(keywords[n++ & 7]);
+				KeepValue(k.RawValue());
+			}, iterations));
+
+		Report(output, "NamedEnum from span, ignoring case", TimePerCall([&n]() noexcept
+			{
+				const char * const s = mixedCaseKeywords[n++ & 7];
+				const BenchKeyword k(s, strlen(s), true);
+				KeepValue(k.RawValue());
+			}, iterations));
+	}
+}
+
+// End
@@ -0,0 +1,89 @@
+/*
+ * GCodeFieldScannerCheck.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Check that GCodeFieldScanner splits lines into the correct fields
+ */
+
+#include "Bench.h"
+#include <General/GCodeFieldScanner.h>
+#include <General/SafeVsnprintf.h>
+#include <cstring>
+#include <cmath>
+
+namespace Bench
+{
+	struct ExpectedField
+	{
+		char letter;
+		bool hasValue;
+		float value;
+	};
+
+	struct ScannerTestCase
+	{
+		const char *line;
+		size_t numFields;
+		ExpectedField fields[6];
+		size_t endPosition;
+	};
+
+	static const ScannerTestCase scannerTestCases[] =
+	{
+		{ "G1X10E1.5",					3, { { 'G', true, 1.0 }, { 'X', true, 10.0 }, { 'E', true, 1.5 } },											9 },
+		{ "G1 X2E3 Y1",					4, { { 'G', true, 1.0 }, { 'X', true, 2.0 }, { 'E', true, 3.0 }, { 'Y', true, 1.0 } },						10 },
+		{ "G1 X10.5 Y-2 E0.25 F3000",	5, { { 'G', true, 1.0 }, { 'X', true, 10.5 }, { 'Y', true, -2.0 }, { 'E', true, 0.25 }, { 'F', true, 3000.0 } },	24 },
+		{ "g1 x1e-2",					3, { { 'G', true, 1.0 }, { 'X', true, 1.0 }, { 'E', true, -2.0 } },											8 },
+		{ "G28 XY",						3, { { 'G', true, 28.0 }, { 'X', false, 0.0 }, { 'Y', false, 0.0 } },										6 },
+		{ "M104 S200 ; set temperature", 2, { { 'M', true, 104.0 }, { 'S', true, 200.0 } },															10 },
+		{ "G1XE",						3, { { 'G', true, 1.0 }, { 'X', false, 0.0 }, { 'E', false, 0.0 } },										4 },
+	};
+
+	static bool ReportScannerFailure(OutputFunction output, const char *line, const char *what) noexcept
+	{
+		char buf[100];
+		SafeSnprintf(buf, sizeof(buf), "FAIL: GCodeFieldScanner \"%s\": %s", line, what);
+		output(buf);
+		return false;
+	}
+
+	static bool CheckScannerTestCase(OutputFunction output, const ScannerTestCase& tc) noexcept
+	{
+		GCodeFieldScanner scanner;
+		if (scanner.Scan(tc.line, strlen(tc.line)) != tc.numFields)
+		{
+			return ReportScannerFailure(output, tc.line, "wrong number of fields");
+		}
+		for (size_t i = 0; i < tc.numFields; ++i)
+		{
+			const GCodeField& f = scanner.GetField(i);
+			const ExpectedField& e = tc.fields[i];
+			if (f.letter != e.letter || f.hasValue != e.hasValue || (e.hasValue && fabsf(f.GetFloatValue() - e.value) > 1.0e-6f))
+			{
+				return ReportScannerFailure(output, tc.line, "wrong field");
+			}
+		}
+		if (scanner.GetEndPosition() != tc.endPosition)
+		{
+			return ReportScannerFailure(output, tc.line, "wrong end position");
+		}
+		return true;
+	}
+
+	bool CheckGCodeFieldScanner(OutputFunction output) noexcept
+	{
+		bool ok = true;
+		for (const ScannerTestCase& tc : scannerTestCases)
+		{
+			if (!CheckScannerTestCase(output, tc))
+			{
+				ok = false;
+			}
+		}
+		output((ok) ? "GCodeFieldScanner check passed" : "GCodeFieldScanner check FAILED");
+		return ok;
+	}
+}
+
+// End
@@ -0,0 +1,61 @@
+/*
+ * HostMain.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Program to run the benchmarks on the host. Pass --quick to do fewer iterations.
+ *  Pass --check-isqrt to check the integer square root functions instead, exhaustively unless --quick is also passed.
+ *  Pass --check-gcode to check GCodeFieldScanner instead.
+ */
+
+#include "Bench.h"
+#include <cstdio>
+#include <cstring>
+
+static void OutputLine(const char *line) noexcept
+{
+	puts(line);
+}
+
+int main(int argc, char *argv[])
+{
+	bool quick = false, checkIsqrt = false, checkGCode = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			quick = true;
+		}
+		else if (strcmp(argv[i], "--check-isqrt") == 0)
+		{
+			checkIsqrt = true;
+		}
+		else if (strcmp(argv[i], "--check-gcode") == 0)
+		{
+			checkGCode = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--quick] [--check-isqrt] [--check-gcode]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (checkIsqrt || checkGCode)
+	{
+		bool ok = true;
+		if (checkIsqrt && !Bench::CheckIsqrt(OutputLine, !quick))
+		{
+			ok = false;
+		}
+		if (checkGCode && !Bench::CheckGCodeFieldScanner(OutputLine))
+		{
+			ok = false;
+		}
+		return (ok) ? 0 : 1;
+	}
+	Bench::RunAll(OutputLine, quick);
+	return 0;
+}
+
+// End
@@ -0,0 +1,130 @@
+/*
+ * IsqrtCheck.cpp
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Check that all the integer square root functions return exact results
+ */
+
+#include "Bench.h"
+#include <Math/Isqrt.h>
+#include <General/SafeVsnprintf.h>
+#include <cinttypes>
+
+namespace Bench
+{
+	// Simple pseudo-random number generator, so that we get the same sequence on every platform
+	static uint64_t NextRandom(uint64_t& state) noexcept
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	// Return true if r is the integer part of the square root of num, where num < 2^62
+	static bool IsExactRoot(uint64_t num, uint32_t r) noexcept
+	{
+		const uint64_t r2 = (uint64_t)r * r;
+		return r2 <= num && num - r2 <= 2 * (uint64_t)r;				// (r+1)^2 > num is the same as num - r^2 <= 2r
+	}
+
+	static bool Report32(OutputFunction output, const char *name, uint32_t num, uint32_t rslt) noexcept
+	{
+		char line[80];
+		SafeSnprintf(line, sizeof(line), "FAIL: %s(%" PRIu32 ") returned %" PRIu32, name, num, rslt);
+		output(line);
+		return false;
+	}
+
+	static bool Report64(OutputFunction output, const char *name, uint64_t num, uint32_t rslt) noexcept
+	{
+		char line[80];
+		SafeSnprintf(line, sizeof(line), "FAIL: %s(%" PRIu64 ") returned %" PRIu32, name, num, rslt);
+		output(line);
+		return false;
+	}
+
+	// Check a 32-bit input against all the functions
+	static bool Check32(OutputFunction output, uint32_t num) noexcept
+	{
+		const uint32_t expected = isqrt32(num);
+		if (!IsExactRoot(num, expected))
+		{
+			return Report32(output, "isqrt32", num, expected);
+		}
+		uint32_t r;
+		if ((r = isqrt32Normalised(num)) != expected) { return Report32(output, "isqrt32Normalised", num, r); }
+		if ((r = isqrt32Fpu(num)) != expected) { return Report32(output, "isqrt32Fpu", num, r); }
+		if ((r = isqrt64(num)) != expected) { return Report32(output, "isqrt64", num, r); }
+		if ((r = isqrt64Fpu(num)) != expected) { return Report32(output, "isqrt64Fpu", num, r); }
+		return true;
+	}
+
+	// Check a 62-bit input against the 64-bit functions
+	static bool Check64(OutputFunction output, uint64_t num) noexcept
+	{
+		uint32_t r;
+		if (!IsExactRoot(num, r = isqrt64(num))) { return Report64(output, "isqrt64", num, r); }
+		if (!IsExactRoot(num, r = isqrt64Fpu(num))) { return Report64(output, "isqrt64Fpu", num, r); }
+		return true;
+	}
+
+	bool CheckIsqrt(OutputFunction output, bool exhaustive) noexcept
+	{
+		unsigned int numFailures = 0;
+
+		// Check every 32-bit input, or when not doing an exhaustive check, every 997th one
+		const uint32_t step = (exhaustive) ? 1 : 997;
+		uint32_t num = 0;
+		do
+		{
+			if (!Check32(output, num) && ++numFailures == 10)
+			{
+				return false;
+			}
+			num = (0xFFFFFFFFu - num < step) ? 0 : num + step;
+		} while (num != 0);
+
+		// Check the squares and their neighbours, which are where an inexact result is most likely
+		uint64_t state = 0x9E3779B97F4A7C15u;
+		for (uint32_t i = 0; i < ((exhaustive) ? 50000000u : 100000u); ++i)
+		{
+			const uint64_t rnd = NextRandom(state);
+			uint64_t x;
+			switch (i % 4)
+			{
+			case 0:
+				{
+					const uint64_t root = rnd >> 33;								// up to 31 bits
+					x = root * root - (uint64_t)((rnd & 1u) != 0 && root != 0);	// a square or one less
+				}
+				break;
+			case 1:
+				{
+					const uint64_t root = rnd >> 33;
+					x = root * root + 2 * root;									// one less than the next square
+				}
+				break;
+			default:
+				x = rnd >> (2 + (rnd & 31u));								// up to 62 bits
+				break;
+			}
+			if (!Check64(output, x) && ++numFailures == 10)
+			{
+				return false;
+			}
+		}
+
+		// The largest input that the 64-bit functions support
+		if (!Check64(output, 0x3FFFFFFFFFFFFFFFu))
+		{
+			++numFailures;
+		}
+
+		output((numFailures == 0) ? "isqrt check passed" : "isqrt check FAILED");
+		return numFailures == 0;
+	}
+}
+
+// End
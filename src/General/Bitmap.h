@@ -41,7 +41,23 @@ inline unsigned int LowestSetBit(unsigned long long val) noexcept
 template<class BaseType> class Bitmap
 {
 public:
-	Bitmap() noexcept : bits(0) { }
+	// Class to iterate over the numbers of the set bits in ascending order, so that we can use a range-based for loop
+	class Iterator
+	{
+	public:
+		unsigned int operator*() const noexcept { return ::LowestSetBit(remaining); }
+		Iterator& operator++() noexcept { remaining &= remaining - 1; return *this; }
+		bool operator==(const Iterator& other) const noexcept { return remaining == other.remaining; }
+		bool operator!=(const Iterator& other) const noexcept { return remaining != other.remaining; }
+
+	private:
+		friend class Bitmap<BaseType>;
+		explicit Iterator(BaseType b) noexcept : remaining(b) { }
+
+		BaseType remaining;			// the bits we haven't returned yet
+	};
+
+	constexpr Bitmap() noexcept : bits(0) { }
 
 	static constexpr unsigned int MaxBits() noexcept { return sizeof(BaseType) * CHAR_BIT; }
 	constexpr BaseType GetRaw() const noexcept { return bits; }
@@ -149,45 +165,50 @@ public:
 		return ::LowestSetBit(bits);
 	}
 
-	// Iterate over the bits
-	void Iterate(std::function<void(unsigned int, unsigned int) /*noexcept*/ > func) const noexcept;
-	bool IterateWhile(std::function<bool(unsigned int, unsigned int) /*noexcept*/ > func) const noexcept;
+	// Iterate over the bits. The function is called with the bit number and the count of bits already visited.
+	// These take any callable object, so that when it is a lambda the calls can be inlined.
+	template<class F> void Iterate(F&& func) const noexcept;
+	template<class F> bool IterateWhile(F&& func) const noexcept;
+
+	Iterator begin() const noexcept { return Iterator(bits); }
+	Iterator end() const noexcept { return Iterator(0); }
 
 	// Make a bitmap with the lowest n bits set
-	static Bitmap<BaseType> MakeLowestNBits(unsigned int n) noexcept
+	static constexpr Bitmap<BaseType> MakeLowestNBits(unsigned int n) noexcept
 	{
 		return Bitmap<BaseType>(((BaseType)1u << n) - 1);
 	}
 
 	// Convert an unsigned integer to a bit in a bitmap
-	static Bitmap<BaseType> MakeFromBits(unsigned int b1) noexcept
+	static constexpr Bitmap<BaseType> MakeFromBits(unsigned int b1) noexcept
 	{
 		return Bitmap<BaseType>((BaseType)1u <<b1);
 	}
 
 	// Convert an unsigned integer to a bit in a bitmap
-	static Bitmap<BaseType> MakeFromBits(unsigned int b1, unsigned int b2) noexcept
+	static constexpr Bitmap<BaseType> MakeFromBits(unsigned int b1, unsigned int b2) noexcept
 	{
 		return Bitmap<BaseType>((BaseType)1u << b1 | (BaseType)1u << b2);
 	}
 
 	// Convert an unsigned integer to a bit in a bitmap
-	static Bitmap<BaseType> MakeFromBits(unsigned int b1, unsigned int b2, unsigned int b3) noexcept
+	static constexpr Bitmap<BaseType> MakeFromBits(unsigned int b1, unsigned int b2, unsigned int b3) noexcept
 	{
 		return Bitmap<BaseType>((BaseType)1u << b1 | (BaseType)1u << b2 |  (BaseType)1u << b3);
 	}
 
 	// Convert an unsigned integer to a bit in a bitmap
-	static Bitmap<BaseType> MakeFromRaw(BaseType b) noexcept
+	static constexpr Bitmap<BaseType> MakeFromRaw(BaseType b) noexcept
 	{
 		return Bitmap<BaseType>(b);
 	}
 
-	// Convert an array of longs to a bit map with overflow checking
-	static Bitmap<BaseType> MakeFromArray(const uint32_t *arr, size_t numEntries) noexcept;
+	// Convert an array of longs to a bit map with overflow checking. This can be evaluated at compile time.
+	static constexpr Bitmap<BaseType> MakeFromArray(const uint32_t *arr, size_t numEntries) noexcept;
+	template<size_t NumEntries> static constexpr Bitmap<BaseType> MakeFromArray(const uint32_t (&arr)[NumEntries]) noexcept { return MakeFromArray(arr, NumEntries); }
 
 private:
-	explicit Bitmap(BaseType n) noexcept : bits(n) { }
+	constexpr explicit Bitmap(BaseType n) noexcept : bits(n) { }
 
 	static constexpr uint8_t BitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
 
@@ -225,7 +246,7 @@ template<class BaseType> int Bitmap<BaseType>::GetSetBitNumber(size_t index) con
 }
 
 // Iterate over the bits
-template<class BaseType> void Bitmap<BaseType>::Iterate(std::function<void(unsigned int, unsigned int) /*noexcept*/ > func) const noexcept
+template<class BaseType> template<class F> void Bitmap<BaseType>::Iterate(F&& func) const noexcept
 {
 	BaseType copyBits = bits;
 	unsigned int count = 0;
@@ -238,8 +259,8 @@ template<class BaseType> void Bitmap<BaseType>::Iterate(std::function<void(unsig
 	}
 }
 
-// Iterate over the bits
-template<class BaseType> bool Bitmap<BaseType>::IterateWhile(std::function<bool(unsigned int, unsigned int) /*noexcept*/ > func) const noexcept
+// Iterate over the bits until the function returns false. Return true if it never did.
+template<class BaseType> template<class F> bool Bitmap<BaseType>::IterateWhile(F&& func) const noexcept
 {
 	BaseType copyBits = bits;
 	unsigned int count = 0;
@@ -257,7 +278,7 @@ template<class BaseType> bool Bitmap<BaseType>::IterateWhile(std::function<bool(
 }
 
 // Convert an array of longs to a bit map with overflow checking
-template<class BaseType> Bitmap<BaseType> Bitmap<BaseType>::MakeFromArray(const uint32_t *arr, size_t numEntries) noexcept
+template<class BaseType> constexpr Bitmap<BaseType> Bitmap<BaseType>::MakeFromArray(const uint32_t *arr, size_t numEntries) noexcept
 {
 	BaseType res = 0;
 	for (size_t i = 0; i < numEntries; ++i)
@@ -272,9 +293,43 @@ template<class BaseType> Bitmap<BaseType> Bitmap<BaseType>::MakeFromArray(const
 }
 
 // Class to hold a bitmap that won't fit into a single object f integral type
+// Bits numbered N and above are never set, so the word-wide operations don't need to mask them off.
 template<unsigned int N> class LargeBitmap
 {
 public:
+	// Class to iterate over the numbers of the set bits in ascending order, so that we can use a range-based for loop
+	class Iterator
+	{
+	public:
+		unsigned int operator*() const noexcept { return (wordIndex << 5) + LowestSetBit(remaining); }
+		Iterator& operator++() noexcept { remaining &= remaining - 1; Advance(); return *this; }
+		bool operator==(const Iterator& other) const noexcept { return wordIndex == other.wordIndex && remaining == other.remaining; }
+		bool operator!=(const Iterator& other) const noexcept { return !operator==(other); }
+
+	private:
+		friend class LargeBitmap<N>;
+
+		Iterator(const uint32_t *p_data, unsigned int p_wordIndex) noexcept
+			: data(p_data), wordIndex(p_wordIndex), remaining((p_wordIndex < numDwords) ? p_data[p_wordIndex] : 0) { Advance(); }
+
+		// Move to the next word if we have used all the set bits in the current one
+		void Advance() noexcept
+		{
+			while (remaining == 0 && wordIndex < numDwords)
+			{
+				++wordIndex;
+				if (wordIndex < numDwords)
+				{
+					remaining = data[wordIndex];
+				}
+			}
+		}
+
+		const uint32_t *data;
+		unsigned int wordIndex;
+		uint32_t remaining;			// the bits in the current word that we haven't returned yet
+	};
+
 	void ClearAll() noexcept;
 
 	void SetBit(unsigned int n) noexcept
@@ -300,10 +355,29 @@ public:
 
 	unsigned int FindLowestSetBit() const noexcept;
 
+	// Find the lowest set bit numbered n or higher, returning N if there isn't one
+	unsigned int FindNextSetBit(unsigned int n) const noexcept;
+
+	bool IsEmpty() const noexcept;
+	unsigned int CountSetBits() const noexcept;
+	bool Intersects(const LargeBitmap<N>& other) const noexcept;
+
+	LargeBitmap<N>& operator&=(const LargeBitmap<N>& other) noexcept;
+	LargeBitmap<N>& operator|=(const LargeBitmap<N>& other) noexcept;
+	LargeBitmap<N>& operator^=(const LargeBitmap<N>& other) noexcept;
+	LargeBitmap<N> operator&(const LargeBitmap<N>& other) const noexcept { LargeBitmap<N> rslt = *this; return rslt &= other; }
+	LargeBitmap<N> operator|(const LargeBitmap<N>& other) const noexcept { LargeBitmap<N> rslt = *this; return rslt |= other; }
+	LargeBitmap<N> operator^(const LargeBitmap<N>& other) const noexcept { LargeBitmap<N> rslt = *this; return rslt ^= other; }
+	bool operator==(const LargeBitmap<N>& other) const noexcept;
+	bool operator!=(const LargeBitmap<N>& other) const noexcept { return !operator==(other); }
+
+	Iterator begin() const noexcept { return Iterator(data, 0); }
+	Iterator end() const noexcept { return Iterator(data, numDwords); }
+
 	static constexpr unsigned int NumBits() noexcept { return N; }
 
 private:
-	static constexpr size_t numDwords = (N + 31/32);
+	static constexpr size_t numDwords = (N + 31)/32;
 
 	uint32_t data[numDwords];
 };
@@ -328,4 +402,100 @@ template<unsigned int N> unsigned int LargeBitmap<N>::FindLowestSetBit() const n
 	return N;
 }
 
+template<unsigned int N> unsigned int LargeBitmap<N>::FindNextSetBit(unsigned int n) const noexcept
+{
+	if (n < N)
+	{
+		unsigned int i = n >> 5;
+		uint32_t w = data[i] & (0xFFFFFFFFu << (n & 31));		// ignore the bits below n in the first word
+		for (;;)
+		{
+			if (w != 0)
+			{
+				return (i << 5) + LowestSetBit(w);
+			}
+			++i;
+			if (i == numDwords)
+			{
+				break;
+			}
+			w = data[i];
+		}
+	}
+	return N;
+}
+
+template<unsigned int N> bool LargeBitmap<N>::IsEmpty() const noexcept
+{
+	for (uint32_t v : data)
+	{
+		if (v != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template<unsigned int N> unsigned int LargeBitmap<N>::CountSetBits() const noexcept
+{
+	unsigned int count = 0;
+	for (uint32_t v : data)
+	{
+		count += (unsigned int)__builtin_popcount(v);
+	}
+	return count;
+}
+
+template<unsigned int N> bool LargeBitmap<N>::Intersects(const LargeBitmap<N>& other) const noexcept
+{
+	for (size_t i = 0; i < numDwords; ++i)
+	{
+		if ((data[i] & other.data[i]) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+template<unsigned int N> LargeBitmap<N>& LargeBitmap<N>::operator&=(const LargeBitmap<N>& other) noexcept
+{
+	for (size_t i = 0; i < numDwords; ++i)
+	{
+		data[i] &= other.data[i];
+	}
+	return *this;
+}
+
+template<unsigned int N> LargeBitmap<N>& LargeBitmap<N>::operator|=(const LargeBitmap<N>& other) noexcept
+{
+	for (size_t i = 0; i < numDwords; ++i)
+	{
+		data[i] |= other.data[i];
+	}
+	return *this;
+}
+
+template<unsigned int N> LargeBitmap<N>& LargeBitmap<N>::operator^=(const LargeBitmap<N>& other) noexcept
+{
+	for (size_t i = 0; i < numDwords; ++i)
+	{
+		data[i] ^= other.data[i];
+	}
+	return *this;
+}
+
+template<unsigned int N> bool LargeBitmap<N>::operator==(const LargeBitmap<N>& other) const noexcept
+{
+	for (size_t i = 0; i < numDwords; ++i)
+	{
+		if (data[i] != other.data[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 #endif /* SRC_GENERAL_BITMAP_H_ */
@@ -13,40 +13,291 @@
 #include <cstddef>
 #include "../RTOSIface/RTOSIface.h"
 
+#if !RRFLIBS_SAMC21
+# include <atomic>
+#endif
+
+// Define FREELIST_MAGAZINE_SIZE as a nonzero value to give each task a private cache (magazine) of up to that many objects of each size in front of the shared freelists.
+// The shared freelist is only used when a magazine is empty or full, so most allocations and releases don't need to synchronise with other tasks.
+// Only tasks with IDs up to FREELIST_MAGAZINE_TASKS get magazines. Objects allocated or released from an ISR always use the shared freelist.
+#ifndef FREELIST_MAGAZINE_SIZE
+# define FREELIST_MAGAZINE_SIZE		0
+#endif
+
+#ifndef FREELIST_MAGAZINE_TASKS
+# define FREELIST_MAGAZINE_TASKS	8
+#endif
+
+#define RRFLIBS_FREELIST_MAGAZINES	(defined(RTOS) && FREELIST_MAGAZINE_SIZE != 0)
+
 namespace FreelistManager
 {
 	// Free list manager class
+	// On processors that support exclusive access instructions the freelists are lock-free, so Release may be called from an ISR.
+	// Allocate may be called from an ISR too, but only if the freelist is known not to be empty, because otherwise it falls back to calling operator new.
+	// The SAMC21 doesn't support exclusive access, so on that processor we use a task critical section instead and the functions are not ISR-safe.
+	// When magazines are enabled, objects held in magazines are counted as allocated by GetNumAllocated and GetHighWater, not as free.
 	template<size_t Sz> class Freelist
 	{
 	public:
 		static void *Allocate() noexcept;
 		static void Release(void *p) noexcept;
 
+		// Allocate a contiguous slab of numObjects objects and add them to the freelist
+		static void Reserve(size_t numObjects) noexcept;
+
+		// Set the number of objects to allocate as a single slab when Allocate finds the freelist empty. The default is 1.
+		static void SetRefillChunk(size_t numObjects) noexcept { refillChunk = (numObjects == 0) ? 1 : numObjects; }
+
+		// Statistics
+		static size_t GetNumAllocated() noexcept { return numInUse; }			// number of objects currently allocated to callers
+		static size_t GetNumFree() noexcept { return totalObjects - numInUse; }	// number of objects on the freelist (approximate if objects are being allocated or released concurrently)
+		static size_t GetHighWater() noexcept { return highWater; }			// highest value that GetNumAllocated has reached
+		static size_t GetNumHeapFallbacks() noexcept { return numHeapFallbacks; }	// number of times Allocate found the freelist empty and called operator new
+
 	private:
-		static void *freelist;
+		static_assert(Sz >= sizeof(void *) && Sz % sizeof(void *) == 0, "Freelist object size must be a multiple of the pointer size");
+
+#if RRFLIBS_SAMC21
+		typedef volatile size_t Counter;			// SAMC21 doesn't support atomic operations, so we update these in a critical section
+#else
+		typedef std::atomic<size_t> Counter;
+#endif
+
+		static void *Pop() noexcept;
+		static void *AddSlab(size_t numObjects, bool allocateOne) noexcept;
+		static void PushChain(void *first, void *last) noexcept;
+		static void NoteAllocated() noexcept;
+
+		static void * volatile freelist;
+		static size_t refillChunk;
+		static Counter totalObjects;				// total number of objects we have obtained from the heap
+		static Counter numInUse;
+		static Counter highWater;
+		static Counter numHeapFallbacks;
+
+#if RRFLIBS_FREELIST_MAGAZINES
+		struct Magazine
+		{
+			size_t count;
+			void *objects[FREELIST_MAGAZINE_SIZE];
+		};
+
+		static Magazine *GetMagazine() noexcept;
+
+		static Magazine magazines[FREELIST_MAGAZINE_TASKS];		// indexed by task ID - 1, each one is only accessed by the task that owns it
+#endif
 	};
 
-	template<size_t Sz> void *Freelist<Sz>::freelist = nullptr;
+	template<size_t Sz> void * volatile Freelist<Sz>::freelist = nullptr;
+	template<size_t Sz> size_t Freelist<Sz>::refillChunk = 1;
+	template<size_t Sz> typename Freelist<Sz>::Counter Freelist<Sz>::totalObjects(0);
+	template<size_t Sz> typename Freelist<Sz>::Counter Freelist<Sz>::numInUse(0);
+	template<size_t Sz> typename Freelist<Sz>::Counter Freelist<Sz>::highWater(0);
+	template<size_t Sz> typename Freelist<Sz>::Counter Freelist<Sz>::numHeapFallbacks(0);
+
+#if RRFLIBS_FREELIST_MAGAZINES
+
+	template<size_t Sz> typename Freelist<Sz>::Magazine Freelist<Sz>::magazines[FREELIST_MAGAZINE_TASKS];
+
+	// Get the magazine belonging to the calling task, or nullptr if it doesn't have one or we are in an ISR
+	template<size_t Sz> inline typename Freelist<Sz>::Magazine *Freelist<Sz>::GetMagazine() noexcept
+	{
+		if (!IsInInterrupt())
+		{
+			const TaskBase::TaskId id = TaskBase::GetCallerTaskId();
+			if (id != 0 && id <= FREELIST_MAGAZINE_TASKS)
+			{
+				return &magazines[id - 1];
+			}
+		}
+		return nullptr;
+	}
+
+#endif
 
 	template<size_t Sz> void *Freelist<Sz>::Allocate() noexcept
 	{
+#if RRFLIBS_FREELIST_MAGAZINES
+		Magazine * const m = GetMagazine();
+		if (m != nullptr)
+		{
+			if (m->count == 0)
+			{
+				// The magazine is empty, so refill half of it from the shared freelist
+				do
+				{
+					void * const p = Pop();
+					if (p == nullptr)
+					{
+						break;
+					}
+					m->objects[m->count++] = p;
+				} while (m->count < FREELIST_MAGAZINE_SIZE/2);
+			}
+			if (m->count != 0)
+			{
+				return m->objects[--m->count];
+			}
+		}
+#endif
+
+		void * const p = Pop();
+		if (p != nullptr)
+		{
+			return p;
+		}
+
+		{
+#if RRFLIBS_SAMC21
+			TaskCriticalSectionLocker lock;
+#endif
+			++numHeapFallbacks;
+			NoteAllocated();
+		}
+		return AddSlab(refillChunk, true);
+	}
+
+	// Take an object from the shared freelist, returning nullptr if it is empty
+	template<size_t Sz> inline void *Freelist<Sz>::Pop() noexcept
+	{
+#if RRFLIBS_SAMC21
 		TaskCriticalSectionLocker lock;
 
 		if (freelist != nullptr)
 		{
 			void * const p = freelist;
 			freelist = *static_cast<void **>(p);
+			NoteAllocated();
 			return p;
 		}
-		return ::operator new(Sz);
+#else
+		for (;;)
+		{
+			void * const p = LoadExclusive(&freelist);
+			if (p == nullptr)
+			{
+				ClearExclusive();
+				break;
+			}
+			// If another task or ISR pops or pushes an object between the load and the store, the store will fail and we try again
+			if (StoreExclusive(&freelist, *static_cast<void **>(p)))
+			{
+				NoteAllocated();
+				return p;
+			}
+		}
+#endif
+		return nullptr;
 	}
 
 	template<size_t Sz> void Freelist<Sz>::Release(void *p) noexcept
 	{
+#if RRFLIBS_FREELIST_MAGAZINES
+		Magazine * const m = GetMagazine();
+		if (m != nullptr)
+		{
+			if (m->count == FREELIST_MAGAZINE_SIZE)
+			{
+				// The magazine is full, so return the top half of it to the shared freelist in one operation
+				constexpr size_t numToKeep = FREELIST_MAGAZINE_SIZE/2;
+				for (size_t i = numToKeep; i + 1 < FREELIST_MAGAZINE_SIZE; ++i)
+				{
+					*static_cast<void **>(m->objects[i]) = m->objects[i + 1];
+				}
+				PushChain(m->objects[numToKeep], m->objects[FREELIST_MAGAZINE_SIZE - 1]);
+				{
+# if RRFLIBS_SAMC21
+					TaskCriticalSectionLocker lock;
+# endif
+					numInUse -= FREELIST_MAGAZINE_SIZE - numToKeep;
+				}
+				m->count = numToKeep;
+			}
+			m->objects[m->count++] = p;
+			return;
+		}
+#endif
+
+#if RRFLIBS_SAMC21
 		TaskCriticalSectionLocker lock;
 
 		*static_cast<void **>(p) = freelist;
 		freelist = p;
+		--numInUse;
+#else
+		do
+		{
+			*static_cast<void **>(p) = LoadExclusive(&freelist);
+		} while (!StoreExclusive(&freelist, p));
+		--numInUse;
+#endif
+	}
+
+	template<size_t Sz> void Freelist<Sz>::Reserve(size_t numObjects) noexcept
+	{
+		if (numObjects != 0)
+		{
+			(void)AddSlab(numObjects, false);
+		}
+	}
+
+	// Allocate a slab of objects from the heap and add them to the freelist, optionally keeping the first one back.
+	// Return a pointer to the start of the slab, which is the object kept back if allocateOne is true.
+	template<size_t Sz> void *Freelist<Sz>::AddSlab(size_t numObjects, bool allocateOne) noexcept
+	{
+		char * const slab = static_cast<char *>(::operator new(numObjects * Sz));
+		{
+#if RRFLIBS_SAMC21
+			TaskCriticalSectionLocker lock;
+#endif
+			totalObjects += numObjects;
+		}
+
+		// Chain together the objects that we are not returning to the caller, then add them to the freelist in a single operation
+		char * const first = (allocateOne) ? slab + Sz : slab;
+		char * const last = slab + (numObjects - 1) * Sz;
+		if (first <= last)
+		{
+			for (char *q = first; q < last; q += Sz)
+			{
+				*reinterpret_cast<void **>(q) = q + Sz;
+			}
+			PushChain(first, last);
+		}
+		return slab;
+	}
+
+	// Add a chain of objects to the freelist
+	template<size_t Sz> void Freelist<Sz>::PushChain(void *first, void *last) noexcept
+	{
+#if RRFLIBS_SAMC21
+		TaskCriticalSectionLocker lock;
+
+		*static_cast<void **>(last) = freelist;
+		freelist = first;
+#else
+		do
+		{
+			*static_cast<void **>(last) = LoadExclusive(&freelist);
+		} while (!StoreExclusive(&freelist, first));
+#endif
+	}
+
+	// Update the in-use count and the high water mark after allocating an object. On the SAMC21 this must be called from within a critical section.
+	template<size_t Sz> inline void Freelist<Sz>::NoteAllocated() noexcept
+	{
+#if RRFLIBS_SAMC21
+		const size_t nowInUse = ++numInUse;
+		if (nowInUse > highWater)
+		{
+			highWater = nowInUse;
+		}
+#else
+		const size_t nowInUse = ++numInUse;
+		size_t oldHighWater = highWater.load();
+		while (nowInUse > oldHighWater && !highWater.compare_exchange_weak(oldHighWater, nowInUse)) { }
+#endif
 	}
 
 	// Macro to return the size of objects of a given type rounded up to a multiple of 8 bytes.
@@ -67,6 +318,12 @@ namespace FreelistManager
 	{
 		Freelist<RoundedUpSize(sizeof(T))>::Release(p);
 	}
+
+	// Pre-allocate space for a number of objects of a given type, so that we don't need to call operator new when they are allocated
+	template<class T> inline void Reserve(size_t numObjects) noexcept
+	{
+		Freelist<RoundedUpSize(sizeof(T))>::Reserve(numObjects);
+	}
 }
 
 #endif /* SRC_LIBRARIES_GENERAL_FREELISTMANAGER_H_ */
@@ -0,0 +1,84 @@
+/*
+ * GCodeFieldScanner.cpp
+ *
+ *  Created on: 14 Oct 2026
+ */
+
+#include "GCodeFieldScanner.h"
+#include "NumericConverter.h"
+#include <cctype>
+
+size_t GCodeFieldScanner::Scan(const char *line, size_t len) noexcept
+{
+	numFields = 0;
+	size_t pos = 0;
+	// E is the extruder axis letter and G-code need not have spaces between fields, so we must not let NumericConverter read E as an exponent.
+	// So we end the number at E by returning a null instead. This leaves pos pointing at the E, so it is scanned as the next field.
+	auto NextChar = [line, len, &pos]() noexcept -> char
+					{
+						if (pos < len)
+						{
+							++pos;
+						}
+						const char ch = (pos < len) ? line[pos] : '\0';
+						return (ch == 'E' || ch == 'e') ? '\0' : ch;
+					};
+
+	NumericConverter conv;
+	while (numFields < MaxFields)
+	{
+		while (pos < len && (line[pos] == ' ' || line[pos] == '\t'))
+		{
+			++pos;
+		}
+		if (pos == len || !isalpha((unsigned char)line[pos]))
+		{
+			break;
+		}
+
+		GCodeField& f = fields[numFields++];
+		f.letter = (char)toupper((unsigned char)line[pos]);
+		const char c = NextChar();							// skip the letter
+		const size_t valueStart = pos;
+		if (conv.Accumulate(c, true, true, NextChar))
+		{
+			f.hasValue = true;
+			f.isInteger = conv.FitsInInt32();
+			if (f.isInteger)
+			{
+				f.iVal = conv.GetInt32();
+			}
+			else
+			{
+				f.fVal = conv.GetFloat();
+			}
+			const unsigned int digits = conv.GetDigitsAfterPoint();
+			f.digitsAfterPoint = (digits > 255) ? 255 : (uint8_t)digits;
+		}
+		else
+		{
+			// The letter is not followed by a number, so go back to just after the letter
+			pos = valueStart;
+			f.hasValue = f.isInteger = false;
+			f.digitsAfterPoint = 0;
+			f.iVal = 0;
+		}
+	}
+
+	endPosition = pos;
+	return numFields;
+}
+
+const GCodeField *GCodeFieldScanner::Find(char letter) const noexcept
+{
+	for (size_t i = 0; i < numFields; ++i)
+	{
+		if (fields[i].letter == letter)
+		{
+			return &fields[i];
+		}
+	}
+	return nullptr;
+}
+
+// End
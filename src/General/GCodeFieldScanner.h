@@ -0,0 +1,57 @@
+/*
+ * GCodeFieldScanner.h
+ *
+ *  Created on: 14 Oct 2026
+ */
+
+#ifndef SRC_GENERAL_GCODEFIELDSCANNER_H_
+#define SRC_GENERAL_GCODEFIELDSCANNER_H_
+
+#include <cstdint>
+#include <cstddef>
+
+// One letter/number pair from a GCode line, e.g. X10.5
+struct GCodeField
+{
+	char letter;						// the letter, converted to upper case
+	bool hasValue;						// false if the letter was not followed by a number
+	bool isInteger;						// true if the number fits in an int32_t and had no decimal point
+	uint8_t digitsAfterPoint;			// number of decimal digits after the decimal point, saturated at 255
+	union
+	{
+		int32_t iVal;					// the value if isInteger is true
+		float fVal;						// the value if isInteger is false
+	};
+
+	float GetFloatValue() const noexcept { return (isInteger) ? (float)iVal : fVal; }
+};
+
+// Class to extract all the letter/number pairs from a line of GCode in a single pass, e.g. G1 X10.5 Y20.25 Z0.3 E1.234 F3000
+// Scanning stops at the end of the buffer, a null, a newline, a comment, or anything else that isn't a letter optionally followed by a number, for example a quoted string.
+// Numbers may not have exponents, because E is an axis letter, so e.g. X2E3 is two fields X2 and E3.
+class GCodeFieldScanner
+{
+public:
+	static constexpr size_t MaxFields = 16;
+
+	GCodeFieldScanner() noexcept : numFields(0), endPosition(0) { }
+
+	// Scan a line, which need not be null-terminated, returning the number of fields found
+	size_t Scan(const char *line, size_t len) noexcept;
+
+	size_t GetNumFields() const noexcept { return numFields; }
+	const GCodeField& GetField(size_t n) const noexcept { return fields[n]; }
+
+	// Return the first field with the specified upper case letter, or nullptr if there isn't one
+	const GCodeField *Find(char letter) const noexcept;
+
+	// Return the offset in the line of the character that stopped the scan, so that the caller can deal with the remainder of the line
+	size_t GetEndPosition() const noexcept { return endPosition; }
+
+private:
+	GCodeField fields[MaxFields];
+	size_t numFields;
+	size_t endPosition;
+};
+
+#endif /* SRC_GENERAL_GCODEFIELDSCANNER_H_ */
@@ -6,18 +6,45 @@
  */
 
 #include "IP4String.h"
-#include "StringRef.h"
-#include "SafeVsnprintf.h"
+
+// Write a number in the range 0 to 255 in decimal without leading zeros, returning a pointer to the character after it.
+// We always write three characters and then advance the pointer past the ones we want, so that there are no conditional branches.
+static inline char *FormatQuad(char *p, unsigned int q) noexcept
+{
+	const unsigned int hundreds = (q * 41u) >> 12;			// same as q/100 for q < 256
+	const unsigned int rem = q - hundreds * 100u;
+	const unsigned int tens = (rem * 205u) >> 11;			// same as rem/10 for rem < 100
+	const unsigned int units = rem - tens * 10u;
+	p[0] = (char)('0' + hundreds);
+	p += (hundreds != 0);
+	p[0] = (char)('0' + tens);
+	p += (q >= 10);
+	p[0] = (char)('0' + units);
+	return p + 1;
+}
 
 IP4String::IP4String(const uint8_t ip[4]) noexcept
 {
-	SafeSnprintf(buf, sizeof(buf)/sizeof(buf[0]), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+	char *p = FormatQuad(buf, ip[0]);
+	*p++ = '.';
+	p = FormatQuad(p, ip[1]);
+	*p++ = '.';
+	p = FormatQuad(p, ip[2]);
+	*p++ = '.';
+	p = FormatQuad(p, ip[3]);
+	*p = 0;
 }
 
 IP4String::IP4String(uint32_t ip) noexcept
 {
-	SafeSnprintf(buf, sizeof(buf)/sizeof(buf[0]), "%u.%u.%u.%u",
-				(unsigned int)(ip & 0xFFu), (unsigned int)((ip >> 8) & 0xFFu), (unsigned int)((ip >> 16) & 0xFFu), (unsigned int)((ip >> 24) & 0xFFu));
+	char *p = FormatQuad(buf, ip & 0xFFu);
+	*p++ = '.';
+	p = FormatQuad(p, (ip >> 8) & 0xFFu);
+	*p++ = '.';
+	p = FormatQuad(p, (ip >> 16) & 0xFFu);
+	*p++ = '.';
+	p = FormatQuad(p, (ip >> 24) & 0xFFu);
+	*p = 0;
 }
 
 // End
@@ -7,17 +7,115 @@
 
 #include "IPAddress.h"
 
+// Pack 4 bytes into a word with the first one in the least significant byte, as we store IPv4 addresses
+static inline uint32_t PackWord(const uint8_t *p) noexcept
+{
+	return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[0];
+}
+
+static inline void UnpackWord(uint32_t w, uint8_t *p) noexcept
+{
+	p[3] = (uint8_t)(w >> 24);
+	p[2] = (uint8_t)(w >> 16);
+	p[1] = (uint8_t)(w >> 8);
+	p[0] = (uint8_t)w;
+}
+
 void IPAddress::SetV4(const uint8_t ip[4]) noexcept
 {
-	v4Address = ((uint32_t)ip[3] << 24) | ((uint32_t)ip[2] << 16) | ((uint32_t)ip[1] << 8) | (uint32_t)ip[0];
+	v4Address = PackWord(ip);
+#if IPADDRESS_SUPPORT_IPV6
+	ClearV6();
+#endif
 }
 
 void IPAddress::UnpackV4(uint8_t rslt[4]) const noexcept
 {
-	rslt[3] = (uint8_t)(v4Address >> 24);
-	rslt[2] = (uint8_t)(v4Address >> 16);
-	rslt[1] = (uint8_t)(v4Address >> 8);
-	rslt[0] = (uint8_t)v4Address;
+	UnpackWord(v4Address, rslt);
+}
+
+#if IPADDRESS_SUPPORT_IPV6
+
+void IPAddress::SetV6(const uint8_t ip[V6Length]) noexcept
+{
+	v4Address = PackWord(ip);
+	v6Tail[0] = PackWord(ip + 4);
+	v6Tail[1] = PackWord(ip + 8);
+	v6Tail[2] = PackWord(ip + 12);
+	isV6 = true;
+}
+
+void IPAddress::UnpackV6(uint8_t rslt[V6Length]) const noexcept
+{
+	if (isV6)
+	{
+		UnpackWord(v4Address, rslt);
+		UnpackWord(v6Tail[0], rslt + 4);
+		UnpackWord(v6Tail[1], rslt + 8);
+		UnpackWord(v6Tail[2], rslt + 12);
+	}
+	else
+	{
+		// Return the IPv4-mapped address ::ffff:a.b.c.d
+		UnpackWord(0, rslt);
+		UnpackWord(0, rslt + 4);
+		UnpackWord(0xFFFF0000, rslt + 8);
+		UnpackWord(v4Address, rslt + 12);
+	}
+}
+
+#endif
+
+// Parse an IPv4 address in dotted decimal form, returning true if successful
+bool IPAddress::ParseV4(const char *s, size_t len, const char **endptr) noexcept
+{
+	const char * const start = s;
+	const char * const end = s + len;
+	uint32_t rslt = 0;
+	bool ok = false;
+	for (unsigned int quad = 0; quad < 4; ++quad)
+	{
+		if (quad != 0)
+		{
+			if (s == end || *s != '.')
+			{
+				break;
+			}
+			++s;
+		}
+
+		// Read 1 to 3 digits. A leading zero is only allowed if it is the only digit.
+		const char * const quadStart = s;
+		unsigned int val = 0;
+		while (s != end && s - quadStart < 3 && *s >= '0' && *s <= '9')
+		{
+			val = (val * 10) + (unsigned int)(*s - '0');
+			++s;
+		}
+		const size_t numDigits = s - quadStart;
+		if (numDigits == 0 || val > 255 || (numDigits > 1 && *quadStart == '0') || (s != end && *s >= '0' && *s <= '9'))
+		{
+			break;
+		}
+		rslt |= val << (8 * quad);
+		ok = (quad == 3);
+	}
+
+	// Don't accept an address followed by another dot, because that would be accepting a prefix of something that isn't an IPv4 address
+	if (ok && s != end && *s == '.')
+	{
+		ok = false;
+	}
+
+	if (ok)
+	{
+		SetV4LittleEndian(rslt);
+	}
+	if (endptr != nullptr)
+	{
+		*endptr = (ok) ? s : start;
+	}
+	return ok;
 }
 
 // End
@@ -9,11 +9,46 @@
 #define SRC_GENERAL_IPADDRESS_H_
 
 #include <cstdint>
+#include <cstddef>
 
-// Class to represent an IP address. Currently it only supports IPV4 addresses, but eventually it will be expanded to support IPV6 too.
+// Define IPADDRESS_SUPPORT_IPV6 as nonzero to make IPAddress able to hold IPv6 addresses too. This makes it 20 bytes long instead of 4.
+#ifndef IPADDRESS_SUPPORT_IPV6
+# define IPADDRESS_SUPPORT_IPV6		0
+#endif
+
+// Class to represent an IP address. It holds an IPv4 address, and if IPADDRESS_SUPPORT_IPV6 is nonzero it can hold an IPv6 address instead.
+// The first 4 bytes of an IPv6 address are stored in the same place as an IPv4 address, so that comparing IPv4 addresses still starts with a single 32-bit compare.
 class IPAddress
 {
 public:
+	static constexpr size_t V6Length = 16;						// number of bytes in an IPv6 address
+
+#if IPADDRESS_SUPPORT_IPV6
+	constexpr IPAddress() noexcept : v4Address(0), v6Tail{0, 0, 0}, isV6(false) {  }
+	explicit IPAddress(const uint8_t ip[4]) noexcept : v6Tail{0, 0, 0}, isV6(false) { SetV4(ip); }
+	explicit constexpr IPAddress(uint32_t v) : v4Address(v), v6Tail{0, 0, 0}, isV6(false) { }
+
+	constexpr bool operator==(const IPAddress& other) const noexcept
+	{
+		return v4Address == other.v4Address
+			&& isV6 == other.isV6
+			&& (!isV6 || (v6Tail[0] == other.v6Tail[0] && v6Tail[1] == other.v6Tail[1] && v6Tail[2] == other.v6Tail[2]));
+	}
+	constexpr bool operator!=(const IPAddress& other) const noexcept { return !operator==(other); }
+
+	constexpr bool IsV4() const noexcept { return !isV6; }
+	constexpr bool IsV6() const noexcept { return isV6; }
+	constexpr bool IsNull() const noexcept { return v4Address == 0 && (!isV6 || (v6Tail[0] == 0 && v6Tail[1] == 0 && v6Tail[2] == 0)); }
+	constexpr bool IsBroadcast() const noexcept { return v4Address == 0xFFFFFFFF && !isV6; }
+
+	void SetV4LittleEndian(uint32_t ip) noexcept { v4Address = ip; ClearV6(); }
+	void SetV4(const uint8_t ip[4]) noexcept;
+	void SetNull() noexcept { v4Address = 0; ClearV6(); }
+	void SetBroadcast() noexcept { v4Address = 0xFFFFFFFF; ClearV6(); }
+
+	void SetV6(const uint8_t ip[V6Length]) noexcept;
+	void UnpackV6(uint8_t rslt[V6Length]) const noexcept;		// an IPv4 address is returned as an IPv4-mapped IPv6 address
+#else
 	constexpr IPAddress() noexcept : v4Address(0) {  }
 	explicit IPAddress(const uint8_t ip[4]) noexcept { SetV4(ip); }
 	explicit constexpr IPAddress(uint32_t v) : v4Address(v) { }
@@ -25,8 +60,6 @@ public:
 
 	constexpr bool IsV4() const noexcept { return true; }
 	constexpr bool IsV6() const noexcept { return false; }
-	constexpr uint32_t GetV4LittleEndian() const noexcept { return v4Address; }
-	constexpr uint8_t GetQuad(unsigned int n) const noexcept { return (v4Address >> (8 * n)) & 0x00FF; }
 	constexpr bool IsNull() const noexcept { return v4Address == 0; }
 	constexpr bool IsBroadcast() const noexcept { return v4Address == 0xFFFFFFFF; }
 
@@ -34,6 +67,11 @@ public:
 	void SetV4(const uint8_t ip[4]) noexcept;
 	void SetNull() noexcept { v4Address = 0; }
 	void SetBroadcast() noexcept { v4Address = 0xFFFFFFFF; }
+#endif
+
+	// These are only meaningful for IPv4 addresses
+	constexpr uint32_t GetV4LittleEndian() const noexcept { return v4Address; }
+	constexpr uint8_t GetQuad(unsigned int n) const noexcept { return (v4Address >> (8 * n)) & 0x00FF; }
 
 #if 0		// these functions are not currently used
 	uint32_t GetV4BigEndian() const noexcept { return __builtin_bswap32(v4Address); }
@@ -42,8 +80,19 @@ public:
 
 	void UnpackV4(uint8_t rslt[4]) const noexcept;
 
+	// Parse an IPv4 address in dotted decimal form from a buffer of known length, which need not be null-terminated.
+	// There must be exactly 4 decimal numbers in the range 0 to 255 without leading zeros, separated by single dots.
+	// Return true and set this address if successful. If endptr is not null then it is set to point to the first character not used.
+	bool ParseV4(const char *s, size_t len, const char **endptr = nullptr) noexcept;
+
 private:
-	uint32_t v4Address;
+	uint32_t v4Address;						// the IPv4 address, or the first 4 bytes of an IPv6 address
+#if IPADDRESS_SUPPORT_IPV6
+	void ClearV6() noexcept { v6Tail[0] = v6Tail[1] = v6Tail[2] = 0; isV6 = false; }
+
+	uint32_t v6Tail[3];						// the remaining 12 bytes of an IPv6 address, zero for an IPv4 address
+	bool isV6;
+#endif
 };
 
 #endif /* SRC_GENERAL_IPADDRESS_H_ */
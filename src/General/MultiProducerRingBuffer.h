@@ -0,0 +1,237 @@
+/*
+ * MultiProducerRingBuffer.h
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Ring buffer that may be written by any number of tasks and ISRs concurrently, and read by a single getter.
+ */
+
+#ifndef SRC_GENERAL_MULTIPRODUCERRINGBUFFER_H_
+#define SRC_GENERAL_MULTIPRODUCERRINGBUFFER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include "../RTOSIface/RTOSIface.h"
+
+// Multi-producer, single-consumer ring buffer, used for shared diagnostic and log channels.
+// N is the number of slots, which must be a power of 2. Unlike RingBuffer, all the slots can be used.
+// We use memcpy to copy the items, so they must not have non-trivial copy constructors/assignment operators.
+//
+// A producer first claims space by advancing the claim index and incrementing the count of active writers in a single atomic operation.
+// It then copies its data into the claimed space without holding any lock. Finally it decrements the count of active writers.
+// The producer that brings the count to zero publishes everything claimed so far by advancing the put index.
+// So data becomes visible to the getter in the order in which it was claimed, and no producer ever has to wait for another one.
+// On the SAMC21 the claim and release steps disable interrupts for a few instructions, because it has no exclusive access instructions.
+template<class T, size_t N> class MultiProducerRingBuffer
+{
+public:
+	MultiProducerRingBuffer() noexcept : claimState(0), putIndex(0), getIndex(0) { }
+
+	// Store a block returning the number of items actually stored. May be called from any task or ISR.
+	size_t PutBlock(const T* buffer, size_t buflen) noexcept;
+
+	// Store one item returning true if successful. May be called from any task or ISR.
+	bool PutItem(T val) noexcept { return PutBlock(&val, 1) != 0; }
+
+	// Get one item returning true if successful. Only one task or ISR may call the get functions.
+	bool GetItem(T& val) noexcept;
+
+	// Get a block returning the number of items actually fetched
+	size_t GetBlock(T* buffer, size_t buflen) noexcept;
+
+	// Return the number of items we could currently add to the buffer
+	size_t SpaceLeft() const noexcept { return N - ((GetClaimIndex(claimState) - getIndex) & IndexMask); }
+
+	// Return the number of items that have been published and are ready to be fetched
+	size_t ItemsPresent() const noexcept { return (putIndex - getIndex) & IndexMask; }
+
+	// Return true if there are no published items in the buffer
+	bool IsEmpty() const noexcept { return getIndex == putIndex; }
+
+	// Return the capacity
+	static constexpr size_t GetCapacity() noexcept { return N; }
+
+private:
+	// The claim state holds the number of writers in the least significant bits and the claim index in the remaining bits.
+	// The claim, put and get indices are free-running counters modulo 2^24, which we reduce modulo N to get slot numbers.
+	static constexpr unsigned int WriterCountBits = 8;
+	static constexpr uint32_t WriterCountMask = (1u << WriterCountBits) - 1;
+	static constexpr uint32_t IndexMask = 0xFFFFFFFFu >> WriterCountBits;
+
+	static_assert(N > 1 && (N & (N - 1)) == 0, "Number of ring buffer slots must be a power of 2");
+	static_assert(N <= (IndexMask + 1)/2, "Too many ring buffer slots");
+
+	static constexpr uint32_t GetClaimIndex(uint32_t state) noexcept { return state >> WriterCountBits; }
+
+	static void AcquireBarrier() noexcept { std::atomic_thread_fence(std::memory_order_acquire); }
+	static void ReleaseBarrier() noexcept { std::atomic_thread_fence(std::memory_order_release); }
+
+	size_t Claim(size_t buflen, uint32_t& start) noexcept;
+	void FinishedWriting() noexcept;
+#if !RRFLIBS_SAMC21
+	void Publish(uint32_t newPutIndex) noexcept;
+#endif
+
+	volatile uint32_t claimState;			// claim index and number of producers that have claimed space but not finished writing it
+	volatile uint32_t putIndex;				// index of the end of the published data
+	volatile uint32_t getIndex;				// index of the next item to fetch
+	T data[N];
+};
+
+template<class T, size_t N> size_t MultiProducerRingBuffer<T, N>::PutBlock(const T* buffer, size_t buflen) noexcept
+{
+	uint32_t start;
+	const size_t toCopy = Claim(buflen, start);
+	if (toCopy != 0)
+	{
+		AcquireBarrier();								// make sure the getter has finished with the space before we write to it
+		const size_t startSlot = start & (N - 1);
+		const size_t toCopyFirst = N - startSlot;
+		if (toCopy <= toCopyFirst)
+		{
+			memcpy(data + startSlot, buffer, toCopy * sizeof(T));
+		}
+		else
+		{
+			memcpy(data + startSlot, buffer, toCopyFirst * sizeof(T));
+			memcpy(data, buffer + toCopyFirst, (toCopy - toCopyFirst) * sizeof(T));
+		}
+		ReleaseBarrier();								// make sure the data is written before we publish it
+		FinishedWriting();
+	}
+	return toCopy;
+}
+
+// Claim space for up to buflen items, returning the number of items claimed and setting 'start' to the index of the first one claimed
+template<class T, size_t N> size_t MultiProducerRingBuffer<T, N>::Claim(size_t buflen, uint32_t& start) noexcept
+{
+	if (buflen == 0)
+	{
+		return 0;
+	}
+
+#if RRFLIBS_SAMC21
+	const uint32_t primask = SaveAndDisableInterrupts();
+	const uint32_t state = claimState;
+	start = GetClaimIndex(state);
+	const size_t spaceLeft = N - ((start - getIndex) & IndexMask);
+	const size_t toCopy = (buflen < spaceLeft) ? buflen : spaceLeft;
+	if (toCopy != 0 && (state & WriterCountMask) != WriterCountMask)
+	{
+		claimState = state + (toCopy << WriterCountBits) + 1;			// any carry out of the claim index is lost off the top
+		RestoreInterrupts(primask);
+		return toCopy;
+	}
+	RestoreInterrupts(primask);
+	return 0;
+#else
+	for (;;)
+	{
+		const uint32_t state = LoadExclusive(&claimState);
+		start = GetClaimIndex(state);
+		const size_t spaceLeft = N - ((start - getIndex) & IndexMask);
+		const size_t toCopy = (buflen < spaceLeft) ? buflen : spaceLeft;
+		if (toCopy == 0 || (state & WriterCountMask) == WriterCountMask)
+		{
+			ClearExclusive();
+			return 0;
+		}
+		if (StoreExclusive(&claimState, state + (toCopy << WriterCountBits) + 1))	// any carry out of the claim index is lost off the top
+		{
+			return toCopy;
+		}
+	}
+#endif
+}
+
+// Say that we have finished writing the space we claimed. If no other producer is still writing, publish everything that has been claimed.
+template<class T, size_t N> void MultiProducerRingBuffer<T, N>::FinishedWriting() noexcept
+{
+	uint32_t newState;
+#if RRFLIBS_SAMC21
+	const uint32_t primask = SaveAndDisableInterrupts();
+	newState = claimState - 1;
+	claimState = newState;
+	if ((newState & WriterCountMask) == 0)
+	{
+		putIndex = GetClaimIndex(newState);
+	}
+	RestoreInterrupts(primask);
+#else
+	do
+	{
+		newState = LoadExclusive(&claimState) - 1;
+	} while (!StoreExclusive(&claimState, newState));
+
+	if ((newState & WriterCountMask) == 0)
+	{
+		Publish(GetClaimIndex(newState));
+	}
+#endif
+}
+
+#if !RRFLIBS_SAMC21
+
+// Advance the put index, unless a producer that claimed space after us has already advanced it further
+template<class T, size_t N> void MultiProducerRingBuffer<T, N>::Publish(uint32_t newPutIndex) noexcept
+{
+	do
+	{
+		const uint32_t oldPutIndex = LoadExclusive(&putIndex);
+		if (((newPutIndex - oldPutIndex) & IndexMask) > N)
+		{
+			ClearExclusive();							// newPutIndex is behind the current put index
+			return;
+		}
+	} while (!StoreExclusive(&putIndex, newPutIndex));
+}
+
+#endif
+
+template<class T, size_t N> bool MultiProducerRingBuffer<T, N>::GetItem(T& val) noexcept
+{
+	const uint32_t currentGetIndex = getIndex;			// capture volatile
+	if (currentGetIndex != putIndex)
+	{
+		AcquireBarrier();
+		val = data[currentGetIndex & (N - 1)];
+		ReleaseBarrier();
+		getIndex = (currentGetIndex + 1) & IndexMask;
+		return true;
+	}
+	return false;
+}
+
+template<class T, size_t N> size_t MultiProducerRingBuffer<T, N>::GetBlock(T* buffer, size_t buflen) noexcept
+{
+	// Capture volatile variables to avoid reloading them unnecessarily
+	const uint32_t currentGetIndex = getIndex;
+	size_t toCopy = (putIndex - currentGetIndex) & IndexMask;
+	if (buflen < toCopy)
+	{
+		toCopy = buflen;
+	}
+
+	if (toCopy != 0)
+	{
+		AcquireBarrier();
+		const size_t startSlot = currentGetIndex & (N - 1);
+		const size_t toCopyFirst = N - startSlot;
+		if (toCopy <= toCopyFirst)
+		{
+			memcpy(buffer, data + startSlot, toCopy * sizeof(T));
+		}
+		else
+		{
+			memcpy(buffer, data + startSlot, toCopyFirst * sizeof(T));
+			memcpy(buffer + toCopyFirst, data, (toCopy - toCopyFirst) * sizeof(T));
+		}
+		ReleaseBarrier();
+		getIndex = (currentGetIndex + toCopy) & IndexMask;
+	}
+	return toCopy;
+}
+
+#endif /* SRC_GENERAL_MULTIPRODUCERRINGBUFFER_H_ */
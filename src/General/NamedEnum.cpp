@@ -8,14 +8,15 @@
 #include "NamedEnum.h"
 #include <cstddef>
 #include <cstring>
+#include <cctype>
 
 // Function to search the table of names for a match. Returns numNames if not found.
-unsigned int NamedEnumLookup(const char *s, const char * const names[], size_t numNames) noexcept
+unsigned int NamedEnumLookup(const char *s, const char * const names[], unsigned int numNames) noexcept
 {
 	unsigned int low = 0, high = numNames;
 	while (high > low)
 	{
-		const size_t mid = (high - low)/2 + low;
+		const unsigned int mid = (high - low)/2 + low;
 		const int t = strcmp(s, SkipLeadingUnderscore(names[mid]));
 		if (t == 0)
 		{
@@ -33,4 +34,48 @@ unsigned int NamedEnumLookup(const char *s, const char * const names[], size_t n
 	return (low < numNames && strcmp(s, SkipLeadingUnderscore(names[low])) == 0) ? low : numNames;
 }
 
+// Return true if the first len characters of s are the same as the name
+static bool NameMatches(const char *s, size_t len, const char *name, bool ignoreCase) noexcept
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		const char c = name[i];
+		if (c == '\0')
+		{
+			return false;						// the name is shorter than s, so don't read past the end of it
+		}
+		if (c != s[i] && (!ignoreCase || tolower(c) != tolower(s[i])))
+		{
+			return false;
+		}
+	}
+	return name[len] == '\0';
+}
+
+// Function to look up a name using the hash table. Returns numNames if not found.
+unsigned int NamedEnumHashLookup(const char *s, const char * const names[], unsigned int numNames, const uint8_t slots[], unsigned int numSlots, uint32_t seed) noexcept
+{
+	return NamedEnumHashLookup(s, strlen(s), false, names, numNames, slots, numSlots, seed);
+}
+
+// Function to look up a name of known length, optionally ignoring case, using the hash table. Returns numNames if not found.
+unsigned int NamedEnumHashLookup(const char *s, size_t len, bool ignoreCase, const char * const names[], unsigned int numNames, const uint8_t slots[], unsigned int numSlots, uint32_t seed) noexcept
+{
+	if (seed == 0)
+	{
+		// We didn't find a perfect hash when the table was built, so do a linear search
+		for (unsigned int i = 0; i < numNames; ++i)
+		{
+			if (NameMatches(s, len, SkipLeadingUnderscore(names[i]), ignoreCase))
+			{
+				return i;
+			}
+		}
+		return numNames;
+	}
+
+	const unsigned int index = slots[NamedEnumHash(s, len, seed) & (numSlots - 1)];
+	return (index < numNames && NameMatches(s, len, SkipLeadingUnderscore(names[index]), ignoreCase)) ? index : numNames;
+}
+
 // End
@@ -33,14 +33,133 @@
 #define STRINGLIST_15(_v1,_v2,_v3,_v4,_v5,_v6,_v7,_v8,_v9,_v10,_v11,_v12,_v13,_v14,_v15)		#_v1,#_v2,#_v3,#_v4,#_v5,#_v6,#_v7,#_v8,#_v9,#_v10,#_v11,#_v12,#_v13,#_v14,#_v15
 #define STRINGLIST_16(_v1,_v2,_v3,_v4,_v5,_v6,_v7,_v8,_v9,_v10,_v11,_v12,_v13,_v14,_v15,_v16)	#_v1,#_v2,#_v3,#_v4,#_v5,#_v6,#_v7,#_v8,#_v9,#_v10,#_v11,#_v12,#_v13,#_v14,#_v15,#_v16
 
-// Function to search the table of names for a match. Returns numNames if not found.
+#include <cstdint>
+#include <cstddef>
+
+// Function to search the table of names for a match. Returns numNames if not found. The names must be in alphabetical order.
 unsigned int NamedEnumLookup(const char *s, const char * const names[], unsigned int numNames) noexcept;
 
-static inline const char *SkipLeadingUnderscore(const char *s) noexcept
+static inline constexpr const char *SkipLeadingUnderscore(const char *s) noexcept
 {
 	return (*s == '_') ? s + 1 : s;
 }
 
+// Perfect hash table for looking up the names of a NamedEnum, built at compile time.
+// Each name (ignoring any leading underscore) hashes to a different slot, so a lookup needs to hash the string and do one string compare.
+// The hash ignores the case of letters so that we can use the same table for case-insensitive lookups.
+constexpr uint32_t NamedEnumHash(const char *s, size_t len, uint32_t seed) noexcept
+{
+	uint32_t h = seed;
+	for (size_t i = 0; i < len; ++i)
+	{
+		h = (h ^ ((uint8_t)s[i] | 0x20u)) * 16777619u;
+	}
+	return h ^ (h >> 15);
+}
+
+constexpr size_t NamedEnumStrlen(const char *s) noexcept
+{
+	size_t len = 0;
+	while (s[len] != '\0')
+	{
+		++len;
+	}
+	return len;
+}
+
+constexpr bool NamedEnumNamesEqual(const char *s1, const char *s2) noexcept
+{
+	while (*s1 == *s2)
+	{
+		if (*s1 == '\0')
+		{
+			return true;
+		}
+		++s1;
+		++s2;
+	}
+	return false;
+}
+
+// Return the number of hash slots to use for a number of names, which is the next power of 2 that is at least twice the number of names
+constexpr unsigned int NamedEnumHashSlots(unsigned int numNames) noexcept
+{
+	unsigned int numSlots = 1;
+	while (numSlots < 2 * numNames)
+	{
+		numSlots <<= 1;
+	}
+	return numSlots;
+}
+
+template<unsigned int NumNames> struct NamedEnumHashTable
+{
+	static constexpr unsigned int NumSlots = NamedEnumHashSlots(NumNames);
+	static constexpr uint8_t EmptySlot = 0xFF;
+	static_assert(NumNames < EmptySlot, "Too many names");
+
+	uint32_t seed;							// the seed that gives a perfect hash, or 0 if we didn't find one (e.g. names that differ only in case) in which case lookups use a linear search
+	bool namesUnique;						// false if any two names are the same after removing leading underscores
+	uint8_t slots[NumSlots];				// the index of the name that hashes to each slot, or EmptySlot
+};
+
+// Build the hash table by trying seeds until we find one that gives no collisions
+template<unsigned int NumNames> constexpr NamedEnumHashTable<NumNames> MakeNamedEnumHashTable(const char * const (&names)[NumNames]) noexcept
+{
+	using Table = NamedEnumHashTable<NumNames>;
+	constexpr uint32_t MaxSeedsToTry = 10000;
+
+	Table table {};
+	table.namesUnique = true;
+	for (unsigned int i = 0; i < NumNames; ++i)
+	{
+		for (unsigned int j = 0; j < i; ++j)
+		{
+			if (NamedEnumNamesEqual(SkipLeadingUnderscore(names[i]), SkipLeadingUnderscore(names[j])))
+			{
+				table.namesUnique = false;
+				return table;
+			}
+		}
+	}
+
+	for (uint32_t seed = 2166136261u; seed != 2166136261u + MaxSeedsToTry; ++seed)
+	{
+		for (unsigned int slot = 0; slot < Table::NumSlots; ++slot)
+		{
+			table.slots[slot] = Table::EmptySlot;
+		}
+
+		bool ok = true;
+		for (unsigned int i = 0; ok && i < NumNames; ++i)
+		{
+			const char * const name = SkipLeadingUnderscore(names[i]);
+			const unsigned int slot = NamedEnumHash(name, NamedEnumStrlen(name), seed) & (Table::NumSlots - 1);
+			if (table.slots[slot] == Table::EmptySlot)
+			{
+				table.slots[slot] = (uint8_t)i;
+			}
+			else
+			{
+				ok = false;
+			}
+		}
+
+		if (ok)
+		{
+			table.seed = seed;
+			return table;
+		}
+	}
+
+	table.seed = 0;
+	return table;
+}
+
+// Functions to look up a name using the hash table. Return numNames if not found.
+unsigned int NamedEnumHashLookup(const char *s, const char * const names[], unsigned int numNames, const uint8_t slots[], unsigned int numSlots, uint32_t seed) noexcept;
+unsigned int NamedEnumHashLookup(const char *s, size_t len, bool ignoreCase, const char * const names[], unsigned int numNames, const uint8_t slots[], unsigned int numSlots, uint32_t seed) noexcept;
+
 // Macro to declare an enumeration with printable value names
 // Usage example:
 //  NamedEnum(MakeOfCar, ford, vauxhall, bmw);
@@ -50,7 +169,7 @@ static inline const char *SkipLeadingUnderscore(const char *s) noexcept
 //  printf("%s", myCar.ToString());
 //
 // If any of the names is a C++ reserved word, prefix it with a single underscore
-// IMPORTANT! If the constructor from string is used then the names must be in alphabetical order (ignoring the leading underscore), because it uses a binary search
+// The constructor from string uses a perfect hash table that is built at compile time, so the names may be in any order
 #define NamedEnum(_typename, _baseType, _v1, ...) \
 class _typename { \
 public: \
@@ -59,7 +178,9 @@ public: \
 	static constexpr unsigned int NumValues = VA_SIZE(__VA_ARGS__) + 1;											/* count of members */ \
 	_typename(RawType arg) noexcept { v = arg; }																/* constructor */ \
 	explicit _typename(BaseType arg) noexcept { v = static_cast<RawType>(arg); }								/* constructor */ \
-	explicit _typename(const char *s) noexcept { v = static_cast<RawType>(NamedEnumLookup(s, _names, NumValues)); }	/* constructor from string - NAMES MUST BE ORDERED when using this */ \
+	explicit _typename(const char *s) noexcept { v = static_cast<RawType>(NamedEnumHashLookup(s, _names, NumValues, _hashTable.slots, _hashTable.NumSlots, _hashTable.seed)); }	/* constructor from string */ \
+	explicit _typename(const char *s, size_t len, bool ignoreCase = false) noexcept																	/* constructor from a string that need not be null-terminated */ \
+		{ v = static_cast<RawType>(NamedEnumHashLookup(s, len, ignoreCase, _names, NumValues, _hashTable.slots, _hashTable.NumSlots, _hashTable.seed)); } \
 	_typename(const _typename& arg) noexcept { v = arg.v; }														/* copy constructor */ \
 	bool operator==(_typename arg) const noexcept { return v == arg.v; }										/* equality operator */ \
 	bool operator!=(_typename arg) const noexcept { return v != arg.v; }										/* inequality operator */ \
@@ -84,6 +205,8 @@ public: \
 private: \
 	RawType v; \
 	static constexpr const char* _names[NumValues] = { STRINGLIST(_v1, __VA_ARGS__) }; \
+	static constexpr NamedEnumHashTable<NumValues> _hashTable = MakeNamedEnumHashTable(_names); \
+	static_assert(_hashTable.namesUnique, "Duplicate names in NamedEnum"); \
 }
 
 #endif /* SRC_NAMEDENUM_H_ */
@@ -8,186 +8,91 @@
 #include "NumericConverter.h"
 #include <limits>
 #include <cmath>
+#include <cstring>
 
-// Function to read an unsigned integer or real literal and store the values in this object
-// On entry, 'c' is the first character to consume and NextChar is the function to get another character
-// Returns true if a valid number was found. If it returns false then characters may have been consumed.
-// On return the value parsed is: lvalue * 2^twos * 5^fives
+// Version of Accumulate that takes a std::function to get the next character. The version that takes a callable object avoids the overhead of the std::function.
 bool NumericConverter::Accumulate(char c, bool acceptNegative, bool acceptReals, std::function<char()> NextChar) noexcept
 {
-	hadDecimalPoint = hadExponent = isNegative = false;
-	bool hadDigit = false;
-	lvalue = 0;
-	fives = twos = 0;
+	return Accumulate<std::function<char()>&>(c, acceptNegative, acceptReals, NextChar);
+}
 
-	// 1. Skip white space
-	while (c == ' ' || c == '\t')
-	{
-		c = NextChar();
-	}
+// Version of Accumulate that reads from a buffer of known length. Reading past the end of the buffer returns null characters.
+bool NumericConverter::Accumulate(const char *s, size_t len, bool acceptNegative, bool acceptReals, size_t& charsConsumed) noexcept
+{
+	size_t index = 0;
+	const bool ret = Accumulate((len != 0) ? s[0] : '\0', acceptNegative, acceptReals,
+								[s, len, &index]() noexcept -> char
+								{
+									if (index < len)
+									{
+										++index;
+									}
+									return (index < len) ? s[index] : '\0';
+								}
+							   );
+	charsConsumed = index;
+	return ret;
+}
 
-	// 2. Check for a sign
-	if (c == '+')
+// Add another digit to the value when it might not fit in lvalue, or when it no longer fits in lvalue ('overflowed' is true)
+// Once the value has overflowed we just count the remaining digits before the decimal point and ignore those after it
+void NumericConverter::AccumulateLargeDigit(unsigned int digit, bool& overflowed) noexcept
+{
+	if (overflowed)
 	{
-		c = NextChar();
+		if (!hadDecimalPoint)
+		{
+			++fives;
+			++twos;
+		}
 	}
-	else if (c == '-')
+	else if (lvalue <= (std::numeric_limits<uint32_t>::max() - digit)/10u)
 	{
-		if (!acceptNegative)
+		lvalue = (lvalue * 10u) + digit;
+		if (hadDecimalPoint)
 		{
-			return false;
+			--fives;
+			--twos;
 		}
-		isNegative = true;
-		c = NextChar();
 	}
-
-	// Skip leading zeros, but count the number after the decimal point
-	for (;;)
+	else
 	{
-		if (c == '0')
+		const unsigned int fivesDigit = (digit + 1u)/2u;
+		if (lvalue <= (std::numeric_limits<uint32_t>::max() - fivesDigit)/5u)
 		{
-			hadDigit = true;
+			lvalue = (lvalue * 5u) + fivesDigit;
 			if (hadDecimalPoint)
 			{
 				--fives;
-				--twos;
 			}
-		}
-		else if (c == '.' && !hadDecimalPoint && acceptReals)
-		{
-			hadDecimalPoint = true;
+			else
+			{
+				++twos;
+			}
 		}
 		else
 		{
-			break;
-		}
-		c = NextChar();
-	}
-
-	// Read digits and allow a decimal point if we haven't already had one
-	bool overflowed = false;
-	for (;;)
-	{
-		if (isdigit(c))
-		{
-			hadDigit = true;
-			if (overflowed)
+			const unsigned int twosDigit = (digit + 4u)/5u;
+			if (lvalue <= (std::numeric_limits<uint32_t>::max() - twosDigit)/2u)
 			{
-				if (!hadDecimalPoint)
+				lvalue = (lvalue * 2u) + twosDigit;
+				if (hadDecimalPoint)
 				{
-					++fives;
-					++twos;
-				}
-			}
-			else
-			{
-				const unsigned int digit = c - '0';
-				if (   lvalue <= (std::numeric_limits<uint32_t>::max() - 9u)/10u		// avoid slow division if we can
-					|| lvalue <= (std::numeric_limits<uint32_t>::max() - digit)/10u
-				   )
-				{
-					lvalue = (lvalue * 10u) + digit;
-					if (hadDecimalPoint)
-					{
-						--fives;
-						--twos;
-					}
+					--twos;
 				}
 				else
 				{
-					const unsigned int fivesDigit = (digit + 1u)/2u;
-					if (lvalue <= (std::numeric_limits<uint32_t>::max() - fivesDigit)/5u)
-					{
-						lvalue = (lvalue * 5u) + fivesDigit;
-						if (hadDecimalPoint)
-						{
-							--fives;
-						}
-						else
-						{
-							++twos;
-						}
-					}
-					else
-					{
-						const unsigned int twosDigit = (digit + 4u)/5u;
-						if (lvalue <= (std::numeric_limits<uint32_t>::max() - twosDigit)/2u)
-						{
-							lvalue = (lvalue * 2u) + twosDigit;
-							if (hadDecimalPoint)
-							{
-								--twos;
-							}
-							else
-							{
-								++fives;
-							}
-						}
-						else if (!hadDecimalPoint)
-						{
-							++fives;
-							++twos;
-						}
-					}
-					overflowed = true;
+					++fives;
 				}
 			}
+			else if (!hadDecimalPoint)
+			{
+				++fives;
+				++twos;
+			}
 		}
-		else if (c == '.' && !hadDecimalPoint && acceptReals)
-		{
-			hadDecimalPoint = true;
-		}
-		else
-		{
-			break;
-		}
-		c = NextChar();
-	}
-
-	if (!hadDigit)
-	{
-		return false;
-	}
-
-	// Check for an exponent
-	if (acceptReals && toupper(c) == 'E')
-	{
-		c = NextChar();
-
-		// 5a. Check for signed exponent
-		const bool expNegative = (c == '-');
-		if (expNegative || c == '+')
-		{
-			c = NextChar();
-		}
-
-		if (!isdigit(c))
-		{
-			return false;								// E or e not followed by a number
-		}
-
-		// 5b. Read exponent digits
-		hadExponent = true;
-		unsigned int exponent = 0;
-		while (isdigit(c))
-		{
-			exponent = (10u * exponent) + (c - '0');		// could overflow, but anyone using such large numbers is being very silly
-			c = NextChar();
-		}
-
-		if (expNegative)
-		{
-			twos -= exponent;
-			fives -= exponent;
-		}
-		else
-		{
-			twos += exponent;
-			fives += exponent;
-		}
+		overflowed = true;
 	}
-
-	return true;
 }
 
 // Return true if the number fits in an int32 and wasn't specified with a decimal point or an exponent
@@ -219,51 +124,69 @@ uint32_t NumericConverter::GetUint32() const noexcept
 // This macro lets us use a double precision constant, by declaring it as a long double one and then casting it to double.
 #define DOUBLE(_x) ((double)( _x ## L ))
 
-static constexpr double inversePowersOfTen[] =
+// Powers of 10 that are exactly representable as floats (5^10 < 2^24 but 5^11 > 2^24)
+static constexpr float exactFloatPowersOfTen[] =
 {
-	DOUBLE(0.1),
-	DOUBLE(0.01),
-	DOUBLE(0.001),
-	DOUBLE(0.0001),
-	DOUBLE(0.00001),
-	DOUBLE(0.000001),
-	DOUBLE(0.0000001),
-	DOUBLE(0.00000001),
-	DOUBLE(0.000000001),
-	DOUBLE(0.0000000001),
-	DOUBLE(0.00000000001),
-	DOUBLE(0.000000000001)
+	1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0, 10000000.0, 100000000.0, 1000000000.0, 10000000000.0
 };
 
+// Powers of 10 that are exactly representable as doubles (5^22 < 2^53 but 5^23 > 2^53)
+static constexpr double exactDoublePowersOfTen[] =
+{
+	DOUBLE(1.0), DOUBLE(1.0e1), DOUBLE(1.0e2), DOUBLE(1.0e3), DOUBLE(1.0e4), DOUBLE(1.0e5), DOUBLE(1.0e6), DOUBLE(1.0e7),
+	DOUBLE(1.0e8), DOUBLE(1.0e9), DOUBLE(1.0e10), DOUBLE(1.0e11), DOUBLE(1.0e12), DOUBLE(1.0e13), DOUBLE(1.0e14), DOUBLE(1.0e15),
+	DOUBLE(1.0e16), DOUBLE(1.0e17), DOUBLE(1.0e18), DOUBLE(1.0e19), DOUBLE(1.0e20), DOUBLE(1.0e21), DOUBLE(1.0e22)
+};
+
+constexpr int MaxExactFloatPowerOfTen = (int)(sizeof(exactFloatPowersOfTen)/sizeof(exactFloatPowersOfTen[0])) - 1;
+constexpr int MaxExactDoublePowerOfTen = (int)(sizeof(exactDoublePowersOfTen)/sizeof(exactDoublePowersOfTen[0])) - 1;
 
 // Return the value as a float
 float NumericConverter::GetFloat() const noexcept
 {
-	// The common cases are when we have zero to ~12 decimal places and no exponent, so optimise these
-	double dvalue = (double)lvalue;
+	// The value is lvalue * 2^twos * 5^fives where twos and fives differ by at most one, so express it as mantissa * 10^tens
 	const int tens = (twos < fives) ? twos : fives;
-	if (tens != 0)
-	{
-		if (tens < 0 && tens >= -(int)(sizeof(inversePowersOfTen)/sizeof(inversePowersOfTen[0])))
-		{
-			dvalue *= inversePowersOfTen[-tens - 1];
-		}
-		else
-		{
-			dvalue *= pow(DOUBLE(10.0), tens);
-		}
-	}
+	const uint64_t mantissa = (fives > twos) ? (uint64_t)lvalue * 5u : (twos > fives) ? (uint64_t)lvalue * 2u : (uint64_t)lvalue;
 
-	// One of twos and fives may be one greater than the other
-	if (fives > twos)
+	// If the mantissa and the power of 10 are both exactly representable as floats then a single float multiplication or division gives the correctly rounded result.
+	// This covers nearly all the numbers we see in GCode, e.g. coordinates with up to 7 significant digits.
+	if (mantissa <= (1u << 24) && tens >= -MaxExactFloatPowerOfTen && tens <= MaxExactFloatPowerOfTen)
 	{
-		dvalue *= 5;
+		const float fvalue = (tens < 0) ? (float)mantissa/exactFloatPowersOfTen[-tens] : (float)mantissa * exactFloatPowersOfTen[tens];
+		return (isNegative) ? -fvalue : fvalue;
 	}
-	else if (twos > fives)
+
+	// Otherwise if the power of 10 is exactly representable as a double, a single double-precision operation gives the correctly rounded double result.
+	// Converting that to float gives the correctly rounded float result, except when the double result lies exactly halfway between two floats.
+	// In that case we use a fused multiply-add to find out which side of the halfway point the exact result lies.
+	if (tens >= -MaxExactDoublePowerOfTen && tens <= MaxExactDoublePowerOfTen)
 	{
-		dvalue *= 2;
+		const double dmantissa = (double)mantissa;				// exact, because the mantissa is less than 2^35
+		const double power = exactDoublePowersOfTen[(tens < 0) ? -tens : tens];
+		double dvalue = (tens < 0) ? dmantissa/power : dmantissa * power;
+
+		// The result is in the range of normalised floats, so the 29 least significant bits of the double mantissa are the ones lost when we convert to float
+		uint64_t bits;
+		memcpy(&bits, &dvalue, sizeof(bits));
+		if ((bits & ((1ull << 29) - 1)) == (1ull << 28))
+		{
+			// dvalue is halfway between two floats, so find the sign of (exact value - dvalue)
+			const double error = (tens < 0) ? -fma(dvalue, power, -dmantissa) : fma(dmantissa, power, -dvalue);
+			if (error > DOUBLE(0.0))
+			{
+				++bits;
+			}
+			else if (error < DOUBLE(0.0))
+			{
+				--bits;
+			}
+			memcpy(&dvalue, &bits, sizeof(dvalue));
+		}
+		return (isNegative) ? -(float)dvalue : (float)dvalue;
 	}
 
+	// The exponent is very large or very small, so we don't try to get the rounding exactly right
+	const double dvalue = (double)mantissa * pow(DOUBLE(10.0), tens);
 	return (isNegative) ? -(float)dvalue : (float)dvalue;
 }
 
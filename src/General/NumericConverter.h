@@ -9,6 +9,8 @@
 #define SRC_GENERAL_NUMERICCONVERTER_H_
 
 #include <cstdint>
+#include <cstddef>
+#include <cctype>
 #include <functional>
 
 // Class to read fixed and floating point numbers
@@ -17,6 +19,14 @@ class NumericConverter
 public:
 	NumericConverter() noexcept {}
 	bool Accumulate(char c, bool acceptNegative, bool acceptReals, std::function<char() /*noexcept*/> NextChar) noexcept;
+
+	// Version of Accumulate that takes any callable object to get the next character, so that the call can be inlined, e.g. a lambda
+	template<class NextCharFunc> bool Accumulate(char c, bool acceptNegative, bool acceptReals, NextCharFunc&& NextChar) noexcept;
+
+	// Version of Accumulate that reads from a buffer of known length, which need not be null-terminated.
+	// On return, charsConsumed is the number of characters that were part of the number.
+	bool Accumulate(const char *s, size_t len, bool acceptNegative, bool acceptReals, size_t& charsConsumed) noexcept;
+
 	bool FitsInInt32() const noexcept;
 	bool FitsInUint32() const noexcept;
 	int32_t GetInt32() const noexcept;
@@ -26,6 +36,8 @@ public:
 	bool IsNegative() const noexcept { return isNegative; }
 
 private:
+	void AccumulateLargeDigit(unsigned int digit, bool& overflowed) noexcept;
+
 	uint32_t lvalue;
 	int fives;
 	int twos;
@@ -34,4 +46,138 @@ private:
 	bool isNegative;
 };
 
+// Function to read an unsigned integer or real literal and store the values in this object
+// On entry, 'c' is the first character to consume and NextChar is the function to get another character
+// Returns true if a valid number was found. If it returns false then characters may have been consumed.
+// On return the value parsed is: lvalue * 2^twos * 5^fives
+template<class NextCharFunc> bool NumericConverter::Accumulate(char c, bool acceptNegative, bool acceptReals, NextCharFunc&& NextChar) noexcept
+{
+	hadDecimalPoint = hadExponent = isNegative = false;
+	bool hadDigit = false;
+	lvalue = 0;
+	fives = twos = 0;
+
+	// 1. Skip white space
+	while (c == ' ' || c == '\t')
+	{
+		c = NextChar();
+	}
+
+	// 2. Check for a sign
+	if (c == '+')
+	{
+		c = NextChar();
+	}
+	else if (c == '-')
+	{
+		if (!acceptNegative)
+		{
+			return false;
+		}
+		isNegative = true;
+		c = NextChar();
+	}
+
+	// Skip leading zeros, but count the number after the decimal point
+	for (;;)
+	{
+		if (c == '0')
+		{
+			hadDigit = true;
+			if (hadDecimalPoint)
+			{
+				--fives;
+				--twos;
+			}
+		}
+		else if (c == '.' && !hadDecimalPoint && acceptReals)
+		{
+			hadDecimalPoint = true;
+		}
+		else
+		{
+			break;
+		}
+		c = NextChar();
+	}
+
+	// Read digits and allow a decimal point if we haven't already had one
+	bool overflowed = false;
+	for (;;)
+	{
+		if (isdigit(c))
+		{
+			hadDigit = true;
+			const unsigned int digit = c - '0';
+			if (!overflowed && lvalue <= (0xFFFFFFFFu - 9u)/10u)		// avoid slow division if we can
+			{
+				lvalue = (lvalue * 10u) + digit;
+				if (hadDecimalPoint)
+				{
+					--fives;
+					--twos;
+				}
+			}
+			else
+			{
+				AccumulateLargeDigit(digit, overflowed);
+			}
+		}
+		else if (c == '.' && !hadDecimalPoint && acceptReals)
+		{
+			hadDecimalPoint = true;
+		}
+		else
+		{
+			break;
+		}
+		c = NextChar();
+	}
+
+	if (!hadDigit)
+	{
+		return false;
+	}
+
+	// Check for an exponent
+	if (acceptReals && toupper(c) == 'E')
+	{
+		c = NextChar();
+
+		// 5a. Check for signed exponent
+		const bool expNegative = (c == '-');
+		if (expNegative || c == '+')
+		{
+			c = NextChar();
+		}
+
+		if (!isdigit(c))
+		{
+			return false;								// E or e not followed by a number
+		}
+
+		// 5b. Read exponent digits
+		hadExponent = true;
+		unsigned int exponent = 0;
+		while (isdigit(c))
+		{
+			exponent = (10u * exponent) + (c - '0');		// could overflow, but anyone using such large numbers is being very silly
+			c = NextChar();
+		}
+
+		if (expNegative)
+		{
+			twos -= exponent;
+			fives -= exponent;
+		}
+		else
+		{
+			twos += exponent;
+			fives += exponent;
+		}
+	}
+
+	return true;
+}
+
 #endif /* SRC_GENERAL_NUMERICCONVERTER_H_ */
@@ -10,17 +10,41 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <atomic>
 
 // Ring buffer template, used for serial I/O
 // We assume the items are small (e.g. characters, floats) so we pass them by value in PutItem
 // We use memcpy to copy them, so they must not have non-trivial copy constructors/assignment operators
+// If N is zero then the storage is allocated by calling Init. Otherwise N is the number of slots, which must be a power of 2, and the storage is part of the object.
+// Either way, one slot is always left empty so the capacity is one less than the number of slots.
 
-template<class T> class RingBuffer
+// Class to hold the storage for a ring buffer with a fixed number of slots. The capacity is a compile-time constant, so it doesn't need to be loaded in each call.
+template<class T, size_t N> class RingBufferStorage
+{
+protected:
+	static_assert(N > 1 && (N & (N - 1)) == 0, "Number of ring buffer slots must be a power of 2");
+
+	static constexpr size_t capacity = N - 1;
+	volatile T data[N];
+};
+
+// Class to hold the storage for a ring buffer whose size is set at runtime
+template<class T> class RingBufferStorage<T, 0>
+{
+protected:
+	RingBufferStorage() noexcept : capacity(0), data(nullptr) { }
+
+	size_t capacity;			// must be one less than a power of 2
+	volatile T *data;
+};
+
+template<class T, size_t N = 0> class RingBuffer : private RingBufferStorage<T, N>
 {
 public:
 	RingBuffer() noexcept;
 
-	// Initialise and allocate the buffer. numSlots must be a power of 2.
+	// Initialise and allocate the buffer. numSlots must be a power of 2. Only used if N is zero.
 	void Init(size_t numSlots) noexcept;
 
 	// Store one item returning true if successful
@@ -35,6 +59,26 @@ public:
 	// Get a block returning the number of items actually fetched
 	size_t GetBlock(T* buffer, size_t buflen) noexcept;
 
+	// Zero-copy interface for the putter, e.g. a DMA receive driver.
+	// Get the free space starting at the put position, returning the number of contiguous slots that may be written directly. Commit them by calling CommitPut.
+	size_t ReservePut(T*& p) noexcept;
+
+	// As ReservePut but also return the free space at the start of the buffer if the free space wraps round. Returns the total number of free slots.
+	size_t ReservePut(T*& p1, size_t& n1, T*& p2, size_t& n2) noexcept;
+
+	// Make n items written into space returned by ReservePut available to the getter. n must not exceed the number of slots that ReservePut returned.
+	void CommitPut(size_t n) noexcept;
+
+	// Zero-copy interface for the getter, e.g. a DMA transmit driver.
+	// Get the data starting at the get position, returning the number of contiguous items that may be read directly. Release them by calling ConsumeGet.
+	size_t PeekGet(const T*& p) const noexcept;
+
+	// As PeekGet but also return the data at the start of the buffer if the data wraps round. Returns the total number of items available.
+	size_t PeekGet(const T*& p1, size_t& n1, const T*& p2, size_t& n2) const noexcept;
+
+	// Discard n items that were returned by PeekGet. n must not exceed the number of items that PeekGet returned.
+	void ConsumeGet(size_t n) noexcept;
+
 	// Return the number of items we could currently add to the buffer
 	size_t SpaceLeft() const noexcept;
 
@@ -48,20 +92,26 @@ public:
 	size_t GetCapacity() const noexcept { return capacity; }
 
 private:
-	size_t capacity;			// must be one less than a power of 2
+	using RingBufferStorage<T, N>::capacity;
+	using RingBufferStorage<T, N>::data;
+
+	// Memory barriers to order accesses to the storage relative to the index updates, because on the Cortex-M7 write buffers and caches can make them visible out of order.
+	// The getter or putter must use an acquire barrier after reading the other one's index, and a release barrier before writing its own.
+	static void AcquireBarrier() noexcept { std::atomic_thread_fence(std::memory_order_acquire); }
+	static void ReleaseBarrier() noexcept { std::atomic_thread_fence(std::memory_order_release); }
 
 	// Declare the data volatile so that it can be accessed by multiple threads or ISRs (but max 1 getter and 1 putter concurrently)
 	volatile size_t putIndex, getIndex;
-	volatile T *data;
 };
 
-template<class T> RingBuffer<T>::RingBuffer() noexcept
-	: capacity(0), putIndex(0), getIndex(0), data(nullptr)
+template<class T, size_t N> RingBuffer<T, N>::RingBuffer() noexcept
+	: putIndex(0), getIndex(0)
 {
 }
 
-template<class T> void RingBuffer<T>::Init(size_t numSlots) noexcept
+template<class T, size_t N> void RingBuffer<T, N>::Init(size_t numSlots) noexcept
 {
+	static_assert(N == 0, "Init is only used for ring buffers whose size is set at runtime");
 	putIndex = 0;
 	getIndex = 0;
 	if (numSlots > 1)
@@ -76,47 +126,51 @@ template<class T> void RingBuffer<T>::Init(size_t numSlots) noexcept
 	}
 }
 
-template<class T> inline bool RingBuffer<T>::PutItem(T val) noexcept
+template<class T, size_t N> inline bool RingBuffer<T, N>::PutItem(T val) noexcept
 {
 	const size_t oldPutIndex = putIndex;				// capture volatile
 	const size_t newPutIndex = (oldPutIndex + 1) & capacity;
 	if (newPutIndex != getIndex)
 	{
+		AcquireBarrier();
 		data[oldPutIndex] = val;
+		ReleaseBarrier();
 		putIndex = newPutIndex;
 		return true;
 	}
 	return false;
 }
 
-template<class T> inline bool RingBuffer<T>::GetItem(T& val) noexcept
+template<class T, size_t N> inline bool RingBuffer<T, N>::GetItem(T& val) noexcept
 {
 	const size_t currentGetIndex = getIndex;			// capture volatile
 	if (currentGetIndex != putIndex)
 	{
+		AcquireBarrier();
 		val = data[currentGetIndex];
+		ReleaseBarrier();
 		getIndex = (currentGetIndex + 1) & capacity;
 		return true;
 	}
 	return false;
 }
 
-template<class T> inline size_t RingBuffer<T>::SpaceLeft() const noexcept
+template<class T, size_t N> inline size_t RingBuffer<T, N>::SpaceLeft() const noexcept
 {
 	return (getIndex + capacity - putIndex) & capacity;
 }
 
-template<class T> inline size_t RingBuffer<T>::ItemsPresent() const noexcept
+template<class T, size_t N> inline size_t RingBuffer<T, N>::ItemsPresent() const noexcept
 {
 	return (putIndex - getIndex) & capacity;
 }
 
-template<class T> inline bool RingBuffer<T>::IsEmpty() const noexcept
+template<class T, size_t N> inline bool RingBuffer<T, N>::IsEmpty() const noexcept
 {
 	return getIndex == putIndex;
 }
 
-template<class T> size_t RingBuffer<T>::PutBlock(const T* buffer, size_t buflen) noexcept
+template<class T, size_t N> size_t RingBuffer<T, N>::PutBlock(const T* buffer, size_t buflen) noexcept
 {
 	// Capture volatile variables to avoid reloading them unnecessarily
 	const size_t currentGetIndex = getIndex;
@@ -131,6 +185,7 @@ template<class T> size_t RingBuffer<T>::PutBlock(const T* buffer, size_t buflen)
 
 	if (toCopy != 0)
 	{
+		AcquireBarrier();
 		size_t toCopyNext;
 		if (currentGetIndex <= currentPutIndex)
 		{
@@ -140,6 +195,7 @@ template<class T> size_t RingBuffer<T>::PutBlock(const T* buffer, size_t buflen)
 			{
 				// We don't reach the end of the buffer
 				memcpy(const_cast<T*>(data) + currentPutIndex, buffer, toCopy * sizeof(T));
+				ReleaseBarrier();
 				putIndex = currentPutIndex + toCopy;
 				return toCopy;
 			}
@@ -153,12 +209,13 @@ template<class T> size_t RingBuffer<T>::PutBlock(const T* buffer, size_t buflen)
 			toCopyNext = toCopy;
 		}
 		memcpy(const_cast<T*>(data) + currentPutIndex, buffer, toCopyNext * sizeof(T));
+		ReleaseBarrier();
 		putIndex = currentPutIndex + toCopyNext;
 	}
 	return toCopy;
 }
 
-template<class T> size_t RingBuffer<T>::GetBlock(T* buffer, size_t buflen) noexcept
+template<class T, size_t N> size_t RingBuffer<T, N>::GetBlock(T* buffer, size_t buflen) noexcept
 {
 	// Capture volatile variables to avoid reloading them unnecessarily
 	size_t currentGetIndex = getIndex;
@@ -173,6 +230,7 @@ template<class T> size_t RingBuffer<T>::GetBlock(T* buffer, size_t buflen) noexc
 
 	if (toCopy != 0)
 	{
+		AcquireBarrier();
 		size_t toCopyNext;
 		if (currentGetIndex > currentPutIndex)
 		{
@@ -181,11 +239,12 @@ template<class T> size_t RingBuffer<T>::GetBlock(T* buffer, size_t buflen) noexc
 			if (toCopy < toCopyFirst)
 			{
 				// We don't reach the end of the buffer
-				memcpy(buffer, data + currentGetIndex, buffer, toCopy * sizeof(T));
+				memcpy(buffer, const_cast<const T*>(data) + currentGetIndex, toCopy * sizeof(T));
+				ReleaseBarrier();
 				getIndex = currentGetIndex + toCopy;
 				return toCopy;
 			}
-			memcpy(buffer, data + currentGetIndex, buffer, toCopyFirst * sizeof(T));
+			memcpy(buffer, const_cast<const T*>(data) + currentGetIndex, toCopyFirst * sizeof(T));
 			currentGetIndex = 0;
 			toCopyNext = toCopy - toCopyFirst;
 			buffer += toCopyFirst;
@@ -194,10 +253,71 @@ template<class T> size_t RingBuffer<T>::GetBlock(T* buffer, size_t buflen) noexc
 		{
 			toCopyNext = toCopy;
 		}
-		memcpy(buffer, data + currentGetIndex, toCopyNext * sizeof(T));
+		memcpy(buffer, const_cast<const T*>(data) + currentGetIndex, toCopyNext * sizeof(T));
+		ReleaseBarrier();
 		getIndex = currentGetIndex + toCopyNext;
 	}
 	return toCopy;
 }
 
+template<class T, size_t N> inline size_t RingBuffer<T, N>::ReservePut(T*& p) noexcept
+{
+	T *p2;
+	size_t n1, n2;
+	(void)ReservePut(p, n1, p2, n2);
+	return n1;
+}
+
+template<class T, size_t N> size_t RingBuffer<T, N>::ReservePut(T*& p1, size_t& n1, T*& p2, size_t& n2) noexcept
+{
+	// Capture volatile variables to avoid reloading them unnecessarily
+	const size_t currentGetIndex = getIndex;
+	const size_t currentPutIndex = putIndex;
+
+	const size_t total = (currentGetIndex + capacity - currentPutIndex) & capacity;
+	const size_t toEnd = capacity + 1 - currentPutIndex;
+	p1 = const_cast<T*>(data) + currentPutIndex;
+	p2 = const_cast<T*>(data);
+	n1 = (total < toEnd) ? total : toEnd;
+	n2 = total - n1;
+	AcquireBarrier();
+	return total;
+}
+
+template<class T, size_t N> inline void RingBuffer<T, N>::CommitPut(size_t n) noexcept
+{
+	ReleaseBarrier();
+	putIndex = (putIndex + n) & capacity;
+}
+
+template<class T, size_t N> inline size_t RingBuffer<T, N>::PeekGet(const T*& p) const noexcept
+{
+	const T *p2;
+	size_t n1, n2;
+	(void)PeekGet(p, n1, p2, n2);
+	return n1;
+}
+
+template<class T, size_t N> size_t RingBuffer<T, N>::PeekGet(const T*& p1, size_t& n1, const T*& p2, size_t& n2) const noexcept
+{
+	// Capture volatile variables to avoid reloading them unnecessarily
+	const size_t currentGetIndex = getIndex;
+	const size_t currentPutIndex = putIndex;
+
+	const size_t total = (currentPutIndex - currentGetIndex) & capacity;
+	const size_t toEnd = capacity + 1 - currentGetIndex;
+	p1 = const_cast<const T*>(data) + currentGetIndex;
+	p2 = const_cast<const T*>(data);
+	n1 = (total < toEnd) ? total : toEnd;
+	n2 = total - n1;
+	AcquireBarrier();
+	return total;
+}
+
+template<class T, size_t N> inline void RingBuffer<T, N>::ConsumeGet(size_t n) noexcept
+{
+	ReleaseBarrier();
+	getIndex = (getIndex + n) & capacity;
+}
+
 #endif /* SRC_GENERAL_RINGBUFFER_H_ */
@@ -17,6 +17,8 @@
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <climits>
 #include <limits>
 
 #include "SafeStrtod.h"
@@ -138,4 +140,234 @@ unsigned long SafeStrtoul(const char *s, const char **endptr, int base) noexcept
 	return strtoul(s, const_cast<char**>(endptr), base);
 }
 
+// Functions that take a length as well as a string pointer
+
+float SafeStrtof(const char *s, size_t len, const char **endptr) noexcept
+{
+	NumericConverter conv;
+	size_t charsConsumed;
+	if (conv.Accumulate(s, len, true, true, charsConsumed))
+	{
+		if (endptr != nullptr)
+		{
+			*endptr = s + charsConsumed;
+		}
+		return conv.GetFloat();
+	}
+
+	if (endptr != nullptr)
+	{
+		*endptr = s;
+	}
+	return 0.0f;
+}
+
+// Return true if all 4 characters in the word are decimal digits
+static inline bool AllDecimalDigits(uint32_t w) noexcept
+{
+	return (w & 0xF0F0F0F0u) == 0x30303030u && ((w + 0x06060606u) & 0xF0F0F0F0u) == 0x30303030u;
+}
+
+// Convert 4 decimal digits held in a word to binary. The first digit is in the least significant byte because the processor is little-endian.
+static inline uint32_t ConvertFourDecimalDigits(uint32_t w) noexcept
+{
+	w -= 0x30303030u;
+	w = (w * 10u) + (w >> 8);						// byte 0 is now the value of the first two digits and byte 2 the value of the last two
+	return ((w & 0xFFu) * 100u) + ((w >> 16) & 0xFFu);
+}
+
+// Read decimal digits from s up to p_end, accumulating them into 'value' and setting 'overflowed' if the result doesn't fit in 32 bits.
+// We read 4 digits at a time while there are enough of them and the value can't overflow. Return a pointer to the first character that isn't a digit.
+static const char *ReadDecimalDigits(const char *s, const char *p_end, uint32_t& value, bool& overflowed) noexcept
+{
+	uint32_t v = 0;
+#if defined(__arm__) && !defined(__ARM_FEATURE_UNALIGNED)
+	// Unaligned accesses are not available (e.g. M0+, or building with -mno-unaligned-access) so memcpy would read the word a byte at a time.
+	// Read up to 3 digits singly until the pointer is word aligned. The value can't overflow because it is at most 999.
+	// If we stop early because we reach a non-digit, the pointer is still not aligned, so we must not read words at all.
+	while (s != p_end && ((uintptr_t)s & 3u) != 0 && isdigit(*s))
+	{
+		v = (v * 10u) + (unsigned int)(*s - '0');
+		++s;
+	}
+	const bool canReadWords = ((uintptr_t)s & 3u) == 0;
+#else
+	constexpr bool canReadWords = true;
+#endif
+	while (canReadWords && p_end - s >= 4 && v <= (std::numeric_limits<uint32_t>::max() - 9999u)/10000u)
+	{
+		uint32_t w;
+#if defined(__arm__) && !defined(__ARM_FEATURE_UNALIGNED)
+		memcpy(&w, __builtin_assume_aligned(s, sizeof(w)), sizeof(w));		// we checked the alignment before entering the loop, and s only advances by 4
+#else
+		memcpy(&w, s, sizeof(w));						// the compiler uses a single load if the processor supports unaligned accesses
+#endif
+		if (!AllDecimalDigits(w))
+		{
+			break;
+		}
+		v = (v * 10000u) + ConvertFourDecimalDigits(w);
+		s += 4;
+	}
+
+	bool ovf = false;
+	while (s != p_end && isdigit(*s))
+	{
+		const unsigned int digit = *s - '0';
+		if (v <= (std::numeric_limits<uint32_t>::max() - digit)/10u)
+		{
+			v = (v * 10u) + digit;
+		}
+		else
+		{
+			ovf = true;
+		}
+		++s;
+	}
+
+	value = v;
+	overflowed = ovf;
+	return s;
+}
+
+// Read an optionally signed decimal integer in the same way as NumericConverter would, returning a pointer to just after it or nullptr if there wasn't one
+static const char *ReadDecimalInteger(const char *s, const char *p_end, bool acceptNegative, uint32_t& value, bool& isNegative, bool& overflowed) noexcept
+{
+	while (s != p_end && (*s == ' ' || *s == '\t'))
+	{
+		++s;
+	}
+
+	isNegative = false;
+	if (s != p_end && *s == '+')
+	{
+		++s;
+	}
+	else if (s != p_end && *s == '-')
+	{
+		if (!acceptNegative)
+		{
+			return nullptr;
+		}
+		isNegative = true;
+		++s;
+	}
+
+	if (s == p_end || !isdigit(*s))
+	{
+		return nullptr;
+	}
+	return ReadDecimalDigits(s, p_end, value, overflowed);
+}
+
+uint32_t StrToU32(const char *s, size_t len, const char **endptr) noexcept
+{
+	uint32_t value;
+	bool isNegative, overflowed;
+	const char * const p = ReadDecimalInteger(s, s + len, false, value, isNegative, overflowed);
+	if (endptr != nullptr)
+	{
+		*endptr = (p != nullptr) ? p : s;
+	}
+	return (p == nullptr) ? 0
+			: (overflowed) ? std::numeric_limits<uint32_t>::max()
+				: value;
+}
+
+int32_t StrToI32(const char *s, size_t len, const char **endptr) noexcept
+{
+	uint32_t value;
+	bool isNegative, overflowed;
+	const char * const p = ReadDecimalInteger(s, s + len, true, value, isNegative, overflowed);
+	if (endptr != nullptr)
+	{
+		*endptr = (p != nullptr) ? p : s;
+	}
+	return (p == nullptr) ? 0
+			: (!overflowed && value <= (uint32_t)std::numeric_limits<int32_t>::max()) ? ((isNegative) ? -(int32_t)value : (int32_t)value)
+				: (isNegative) ? std::numeric_limits<int32_t>::min()
+					: std::numeric_limits<int32_t>::max();
+}
+
+// Return the value of a digit in bases up to 36, or a value of at least 36 if it isn't a digit
+static inline unsigned int DigitValue(char c) noexcept
+{
+	return (isdigit(c)) ? (unsigned int)(c - '0')
+			: (isalpha(c)) ? (unsigned int)(toupper(c) - 'A' + 10)
+				: 36;
+}
+
+// This behaves like strtoul except that it doesn't accept a minus sign. Only the decimal case uses ReadDecimalDigits, because that is the only common one.
+unsigned long SafeStrtoul(const char *s, size_t len, const char **endptr, int base) noexcept
+{
+	const char * const p_end = s + len;
+	while (s != p_end && (*s == ' ' || *s == '\t'))
+	{
+		++s;
+	}
+	const char * const start = s;					// this is where the other SafeStrtoul leaves the end pointer if there is no number
+	while (s != p_end && isspace(*s))
+	{
+		++s;
+	}
+	if (s != p_end && *s == '+')
+	{
+		++s;
+	}
+	else if (s != p_end && *s == '-')
+	{
+		if (endptr != nullptr)
+		{
+			*endptr = s;							// same as the other SafeStrtoul
+		}
+		return 0;
+	}
+
+	// Check for a 0x prefix or a leading zero meaning octal. A 0x prefix is only skipped if a hex digit follows it.
+	const bool hasHexPrefix = p_end - s >= 3 && s[0] == '0' && toupper(s[1]) == 'X' && isxdigit(s[2]);
+	if (base == 0)
+	{
+		base = (hasHexPrefix) ? 16 : (s != p_end && *s == '0') ? 8 : 10;
+	}
+	if (base == 16 && hasHexPrefix)
+	{
+		s += 2;
+	}
+
+	unsigned long value = 0;
+	bool overflowed = false;
+	const char *p = s;
+	if (base == 10)
+	{
+		uint32_t value32;
+		p = ReadDecimalDigits(s, p_end, value32, overflowed);
+		value = value32;
+	}
+	else if (base >= 2 && base <= 36)
+	{
+		for (; p != p_end; ++p)
+		{
+			const unsigned int digit = DigitValue(*p);
+			if (digit >= (unsigned int)base)
+			{
+				break;
+			}
+			if (value <= (ULONG_MAX - digit)/(unsigned int)base)
+			{
+				value = (value * (unsigned int)base) + digit;
+			}
+			else
+			{
+				overflowed = true;
+			}
+		}
+	}
+
+	if (endptr != nullptr)
+	{
+		*endptr = (p != s) ? p : start;
+	}
+	return (overflowed) ? ULONG_MAX : value;
+}
+
 // End
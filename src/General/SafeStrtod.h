@@ -8,6 +8,9 @@
 #ifndef SRC_LIBRARIES_GENERAL_SAFESTRTOD_H_
 #define SRC_LIBRARIES_GENERAL_SAFESTRTOD_H_
 
+#include <cstdint>
+#include <cstddef>
+
 float SafeStrtof(const char *s, const char **endptr = nullptr) noexcept;
 
 uint32_t StrToU32(const char *s, const char **endptr = nullptr) noexcept;
@@ -17,6 +20,12 @@ int32_t StrToI32(const char *s, const char **endptr = nullptr) noexcept;
 // This next one is still used in places when we may wish to read hex numbers
 unsigned long SafeStrtoul(const char *s, const char **endptr = nullptr, int base = 10) noexcept;
 
+// Versions of the above that read at most len characters, so the string need not be null-terminated
+float SafeStrtof(const char *s, size_t len, const char **endptr) noexcept;
+uint32_t StrToU32(const char *s, size_t len, const char **endptr) noexcept;
+int32_t StrToI32(const char *s, size_t len, const char **endptr) noexcept;
+unsigned long SafeStrtoul(const char *s, size_t len, const char **endptr, int base) noexcept;
+
 #define strtod(s, p) Do_not_use_strtod_use_SafeStrtof_instead
 #define strtof(s, p) Do_not_use_strtof_use_SafeStrtof_instead
 #define strtol(s, ...) Do_not_use_strtol_use_StrToI32_instead
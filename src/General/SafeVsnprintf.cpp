@@ -29,12 +29,74 @@
 #include <cstring>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 
 #include "Strnlen.h"
+#include "SafeVsnprintf.h"
 
 // The following should be enough for 32-bit int/long and 64-bit long long
 constexpr size_t MaxLongDigits = 10;	// to print 4294967296
 constexpr size_t MaxUllDigits = 20;		// to print 18446744073709551616
+constexpr size_t MaxUllOctalDigits = 22;	// to print 1777777777777777777777
+
+// Table of the decimal representations of 00 to 99, so that we can convert numbers to decimal two digits at a time
+static constexpr char DecimalDigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Convert an unsigned 32-bit number to decimal, storing the digits backwards from just before s. Return a pointer to the first digit.
+// We produce two digits per division, and because the divisor is a constant the compiler implements the division as a multiplication by the reciprocal.
+static char *ConvertDecimal32(char *s, uint32_t u) noexcept
+{
+	while (u >= 100)
+	{
+		const uint32_t q = u/100;
+		const uint32_t r = u - q * 100;
+		s -= 2;
+		s[0] = DecimalDigitPairs[2 * r];
+		s[1] = DecimalDigitPairs[2 * r + 1];
+		u = q;
+	}
+	if (u >= 10)
+	{
+		s -= 2;
+		s[0] = DecimalDigitPairs[2 * u];
+		s[1] = DecimalDigitPairs[2 * u + 1];
+	}
+	else
+	{
+		*--s = (char)(u + '0');
+	}
+	return s;
+}
+
+// Convert an unsigned 64-bit number to decimal, storing the digits backwards from just before s. Return a pointer to the first digit.
+// We split the number into chunks of 9 decimal digits so that we need at most two 64-bit divisions, and convert each chunk using 32-bit arithmetic.
+static char *ConvertDecimal64(char *s, uint64_t u) noexcept
+{
+	constexpr uint32_t ChunkDivisor = 1000000000;		// 10^9, the largest power of 10 that fits in 32 bits
+	while (u > 0xFFFFFFFFu)
+	{
+		const uint64_t q = u/ChunkDivisor;
+		const uint32_t r = (uint32_t)u - (uint32_t)q * ChunkDivisor;	// the remainder, calculated modulo 2^32 because it is known to be less than 2^32
+		char * const chunkStart = s - 9;
+		s = ConvertDecimal32(s, r);
+		while (s != chunkStart)
+		{
+			*--s = '0';
+		}
+		u = q;
+	}
+	return ConvertDecimal32(s, (uint32_t)u);
+}
 
 struct xPrintFlags
 {
@@ -55,20 +117,23 @@ struct xPrintFlags
 struct SStringBuf
 {
 	char *str;
-	const char *orgStr;
+	char *orgStr;
 	const char *nulPos;
+	PrintfSink *sink;					// if not null, the buffer holds a batch of characters that we send to the sink when it is full
 	int curLen;
 	struct xPrintFlags flags;
 
-	SStringBuf(char *s, size_t maxLen) noexcept;
+	SStringBuf(char *s, size_t maxLen, PrintfSink *p_sink = nullptr) noexcept;
 	void Init() noexcept;
+	bool Flush() noexcept;
 };
 
-SStringBuf::SStringBuf(char *apBuf, size_t maxLen) noexcept
+SStringBuf::SStringBuf(char *apBuf, size_t maxLen, PrintfSink *p_sink) noexcept
 {
 	str = apBuf;
 	orgStr = apBuf;
 	nulPos = apBuf + maxLen - 1;
+	sink = p_sink;
 	curLen = 0;
 	Init();
 }
@@ -78,19 +143,36 @@ void SStringBuf::Init() noexcept
 	memset(&flags, 0, sizeof(flags));
 }
 
+// Send the characters in the buffer to the sink and empty the buffer. Return true if the sink accepted them.
+bool SStringBuf::Flush() noexcept
+{
+	const size_t numChars = str - orgStr;
+	str = orgStr;
+	if (numChars == 0 || sink->Write(orgStr, numChars))
+	{
+		return true;
+	}
+	curLen -= (int)numChars;
+	sink = nullptr;						// don't send anything else
+	return false;
+}
+
 /*-----------------------------------------------------------*/
 
 // Store the specified character in the string buffer.
-// If it won't fit leaving room for a null, store a null and return false.
+// If it won't fit leaving room for a null, and we are not writing to a sink or the sink won't accept the buffer contents, store a null and return false.
 // If it is null, store it and return false.
 // Else store it and return true.
 static bool strbuf_printchar(SStringBuf& apStr, char c) noexcept
 {
-	if (c != 0 && apStr.str < apStr.nulPos)
+	if (c != 0)
 	{
-		*apStr.str++ = c;
-		apStr.curLen++;
-		return true;
+		if (apStr.str < apStr.nulPos || (apStr.sink != nullptr && apStr.Flush()))
+		{
+			*apStr.str++ = c;
+			apStr.curLen++;
+			return true;
+		}
 	}
 	*apStr.str = '\0';
 	return false;
@@ -200,18 +282,35 @@ static bool printll(SStringBuf& apBuf, long long i) noexcept
 		u = -i;
 	}
 
-	char print_buf[MaxUllDigits + 2];
+	char print_buf[MaxUllOctalDigits + 2];
 	char *s = print_buf + sizeof print_buf - 1;
 	*s = '\0';
-	while (u != 0)
+	switch (apBuf.flags.base)
 	{
-		unsigned int t = u % (unsigned int)apBuf.flags.base;
-		u /= (unsigned int)apBuf.flags.base;
-		if (t >= 10)
+	case 10:
+		s = ConvertDecimal64(s, u);
+		break;
+
+	case 16:
+		while (u != 0)
+		{
+			unsigned int t = (unsigned int)u & 0xF;
+			if (t >= 10)
+			{
+				t += apBuf.flags.letBase - '0' - 10;
+			}
+			*--s = t + '0';
+			u >>= 4;
+		}
+		break;
+
+	case 8:
+		while (u != 0)
 		{
-			t += apBuf.flags.letBase - '0' - 10;
+			*--s = ((unsigned int)u & 7) + '0';
+			u >>= 3;
 		}
-		*--s = t + '0';
+		break;
 	}
 
 	if (neg)
@@ -272,14 +371,15 @@ static bool printi(SStringBuf& apBuf, int i) noexcept
 		}
 		break;
 
-	case 8:
 	case 10:
-		// GCC compiles very efficient
+		s = ConvertDecimal32(s, u);
+		break;
+
+	case 8:
 		while (u != 0)
 		{
-			const unsigned int t = u % base;
-			*--s = t + '0';
-			u /= base;
+			*--s = (u & 7) + '0';
+			u >>= 3;
 		}
 		break;
 #if 0
@@ -322,10 +422,125 @@ static bool printi(SStringBuf& apBuf, int i) noexcept
 
 #ifndef NO_PRINTF_FLOAT
 
+constexpr unsigned int MaxFastFloatDigits = 6;		// the maximum number of decimal places that printFloatFast handles
+static constexpr uint32_t PowersOfTen[MaxFastFloatDigits + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+// Print a number in fixed point format using integer arithmetic only, so that we don't need to use software double-precision maths on processors without a double-precision FPU.
+// This handles the common case, which is that the value passed was promoted from a float, is less than 2^32 in magnitude, and we want no more than 6 decimal places.
+// The value is decoded from its IEEE representation and converted exactly, rounding to even, so the result is the same as printFloat would produce.
+// Return true if the number was handled, in which case 'rslt' is the return value from printing it.
+static bool printFloatFast(SStringBuf& apBuf, double d, unsigned int digitsAfterPoint, bool& rslt) noexcept
+{
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	const bool neg = (bits >> 63) != 0;
+	const unsigned int biasedExponent = (unsigned int)(bits >> 52) & 0x07FF;
+	const uint64_t mantissa = bits & ((1ull << 52) - 1);
+
+	uint32_t intPart, fracPart;
+	if (biasedExponent == 0)
+	{
+		if (mantissa != 0)
+		{
+			return false;								// subnormal double precision number, so it can't have come from a float
+		}
+		intPart = fracPart = 0;
+	}
+	else
+	{
+		if (biasedExponent == 0x07FF || (mantissa & ((1ull << 29) - 1)) != 0)
+		{
+			return false;								// nan or infinity, or a value with more precision than a float
+		}
+
+		// The value is m * 2^exponent where m has 24 significant bits
+		const uint32_t m = (uint32_t)(mantissa >> 29) | (1u << 23);
+		const int exponent = (int)biasedExponent - (1023 + 23);
+		if (exponent > 8)
+		{
+			return false;								// integer part may not fit in 32 bits
+		}
+		if (exponent >= 0)
+		{
+			intPart = m << exponent;
+			fracPart = 0;
+		}
+		else
+		{
+			const unsigned int shift = (unsigned int)-exponent;
+			intPart = (shift < 32) ? m >> shift : 0;
+			const uint32_t frac = (shift < 32) ? m & ((1u << shift) - 1) : m;
+			const uint64_t scaledFrac = (uint64_t)frac * PowersOfTen[digitsAfterPoint];		// less than 2^44
+			if (shift > 45)
+			{
+				fracPart = 0;							// value is less than 1/4 of the least significant digit
+			}
+			else
+			{
+				fracPart = (uint32_t)(scaledFrac >> shift);
+				const uint64_t remainder = scaledFrac & ((1ull << shift) - 1);
+				const uint64_t half = 1ull << (shift - 1);
+				if (remainder > half || (remainder == half && (fracPart & 1u) != 0))
+				{
+					++fracPart;
+					if (fracPart == PowersOfTen[digitsAfterPoint])
+					{
+						fracPart = 0;
+						++intPart;						// can't overflow because intPart is less than 2^24 if we have a fractional part
+					}
+				}
+			}
+		}
+	}
+
+	char print_buf[MaxLongDigits + MaxFastFloatDigits + 3];
+	char *s = print_buf + sizeof print_buf - 1;
+	*s = '\0';
+
+	do
+	{
+		*--s = (char)((fracPart % 10u) + '0');
+		fracPart /= 10u;
+		--digitsAfterPoint;
+	} while (digitsAfterPoint != 0);
+	*--s = '.';
+	s = ConvertDecimal32(s, intPart);
+
+	if (neg && (biasedExponent != 0 || mantissa != 0))
+	{
+		if (apBuf.flags.width != 0 && apBuf.flags.padZero)
+		{
+			if (!strbuf_printchar(apBuf, '-'))
+			{
+				rslt = false;
+				return true;
+			}
+			--apBuf.flags.width;
+		}
+		else
+		{
+			*--s = '-';
+		}
+	}
+
+	rslt = prints(apBuf, s);
+	return true;
+}
+
 // Print a number in scientific format
 // apBuf.flags.printLimit is the number of decimal digits required
 static bool printFloat(SStringBuf& apBuf, double d, char formatLetter) noexcept
 {
+	if (formatLetter == 'f' || formatLetter == 'F')
+	{
+		const unsigned int digitsAfterPoint = (apBuf.flags.printLimit < 0) ? 6 : (unsigned int)apBuf.flags.printLimit;
+		bool rslt;
+		if (digitsAfterPoint != 0 && digitsAfterPoint <= MaxFastFloatDigits && printFloatFast(apBuf, d, digitsAfterPoint, rslt))
+		{
+			return rslt;
+		}
+	}
+
 	if (std::isnan(d))
 	{
 		return prints(apBuf, "nan");
@@ -455,78 +670,117 @@ static bool printFloat(SStringBuf& apBuf, double d, char formatLetter) noexcept
 
 /*-----------------------------------------------------------*/
 
-static void tiny_print(SStringBuf& apBuf, const char *format, va_list args) noexcept
+// Print according to the format. If ops is not null then it is the result of calling ParsePrintfFormat on the format, so we don't need to parse the format again.
+static void tiny_print(SStringBuf& apBuf, const char *format, const PrintfOp *ops, va_list args) noexcept
 {
 	for (;;)
 	{
 		char ch;
-		while ((ch = *format++) != '%')
+		if (ops != nullptr)
 		{
-			if (!strbuf_printchar(apBuf, ch))		// note: this returns false if ch == 0
+			const PrintfOp& op = *ops++;
+			const char *literal = format + op.literalStart;
+			for (unsigned int count = op.literalLength; count != 0; --count)
 			{
-				return;
+				if (!strbuf_printchar(apBuf, *literal++))
+				{
+					return;
+				}
 			}
-		}
 
-		// If we get here then ch == '%'. Get the next character.
-		ch = *format++;
-		if (ch == '\0')
-		{
-			break;
-		}
-		if (ch == '%')
-		{
-			if (strbuf_printchar(apBuf, ch) == 0)
+			ch = op.conversion;
+			if (ch == '\0')
 			{
-				return;
+				break;
+			}
+			if (ch == '%')
+			{
+				if (!strbuf_printchar(apBuf, ch))
+				{
+					return;
+				}
+				continue;
 			}
-			continue;
-		}
-
-		apBuf.Init();
 
-		if (ch == '-')
-		{
-			ch = *format++;
-			apBuf.flags.padRight = true;
-		}
-		while (ch == '0')
-		{
-			ch = *format++;
-			apBuf.flags.padZero = true;
-		}
-		if (ch == '*')
-		{
-			ch = *format++;
-			apBuf.flags.width = va_arg(args, int);
+			apBuf.Init();
+			apBuf.flags.padRight = (op.flags & PrintfOp::PadRight) != 0;
+			apBuf.flags.padZero = (op.flags & PrintfOp::PadZero) != 0;
+			apBuf.flags.long32 = (op.flags & PrintfOp::Long32) != 0;
+			apBuf.flags.long64 = (op.flags & PrintfOp::Long64) != 0;
+			apBuf.flags.width = (op.flags & PrintfOp::WidthFromArg) ? va_arg(args, int) : op.width;
+			apBuf.flags.printLimit = (op.flags & PrintfOp::LimitFromArg) ? va_arg(args, int) : op.printLimit;
 		}
 		else
 		{
-			while(ch >= '0' && ch <= '9')
+			while ((ch = *format++) != '%')
 			{
-				apBuf.flags.width *= 10;
-				apBuf.flags.width += ch - '0';
-				ch = *format++;
+				if (!strbuf_printchar(apBuf, ch))		// note: this returns false if ch == 0
+				{
+					return;
+				}
 			}
-		}
-		if (ch == '.')
-		{
+
+			// If we get here then ch == '%'. Get the next character.
 			ch = *format++;
+			if (ch == '\0')
+			{
+				break;
+			}
+			if (ch == '%')
+			{
+				if (strbuf_printchar(apBuf, ch) == 0)
+				{
+					return;
+				}
+				continue;
+			}
+
+			apBuf.Init();
+
+			if (ch == '-')
+			{
+				ch = *format++;
+				apBuf.flags.padRight = true;
+			}
+			while (ch == '0')
+			{
+				ch = *format++;
+				apBuf.flags.padZero = true;
+			}
 			if (ch == '*')
 			{
-				apBuf.flags.printLimit = va_arg(args, int);
 				ch = *format++;
+				apBuf.flags.width = va_arg(args, int);
 			}
 			else
 			{
-				while (ch >= '0' && ch <= '9')
+				while(ch >= '0' && ch <= '9')
+				{
+					apBuf.flags.width *= 10;
+					apBuf.flags.width += ch - '0';
+					ch = *format++;
+				}
+			}
+			if (ch == '.')
+			{
+				ch = *format++;
+				if (ch == '*')
 				{
-					apBuf.flags.printLimit *= 10;
-					apBuf.flags.printLimit += ch - '0';
+					apBuf.flags.printLimit = va_arg(args, int);
 					ch = *format++;
 				}
+				else
+				{
+					while (ch >= '0' && ch <= '9')
+					{
+						apBuf.flags.printLimit *= 10;
+						apBuf.flags.printLimit += ch - '0';
+						ch = *format++;
+					}
+				}
 			}
 		}
+
 		if (apBuf.flags.printLimit == 0)
 		{
 			apBuf.flags.printLimit = -1;		// -1: make it unlimited
@@ -551,7 +805,7 @@ static void tiny_print(SStringBuf& apBuf, const char *format, va_list args) noex
 
 			continue;
 		}
-		if (ch == 'l')
+		if (ch == 'l' && ops == nullptr)
 		{
 			ch = *format++;
 			if (ch == 'l')
@@ -629,7 +883,7 @@ static void tiny_print(SStringBuf& apBuf, const char *format, va_list args) noex
 int SafeVsnprintf(char *apBuf, size_t aMaxLen, const char *apFmt, va_list args) noexcept
 {
 	SStringBuf strBuf(apBuf, aMaxLen);
-	tiny_print(strBuf, apFmt, args);
+	tiny_print(strBuf, apFmt, nullptr, args);
 	return strBuf.curLen;
 }
 
@@ -642,4 +896,50 @@ int SafeSnprintf(char* buffer, size_t buf_size, const char* format, ...) noexcep
 	return ret;
 }
 
+int SafeVprintfToSink(PrintfSink& sink, const char *format, va_list args) noexcept
+{
+	char batch[SinkBatchSize + 1];								// +1 for the null terminator that tiny_print stores
+	SStringBuf strBuf(batch, sizeof(batch), &sink);
+	tiny_print(strBuf, format, nullptr, args);
+	if (strBuf.sink != nullptr)
+	{
+		(void)strBuf.Flush();
+	}
+	return strBuf.curLen;
+}
+
+int SafePrintfToSink(PrintfSink& sink, const char *format, ...) noexcept
+{
+	va_list vargs;
+	va_start(vargs, format);
+	const int ret = SafeVprintfToSink(sink, format, vargs);
+	va_end(vargs);
+	return ret;
+}
+
+int SafeSnprintfOps(char *buffer, size_t maxLen, const PrintfOp *ops, const char *format, ...) noexcept
+{
+	va_list vargs;
+	va_start(vargs, format);
+	SStringBuf strBuf(buffer, maxLen);
+	tiny_print(strBuf, format, ops, vargs);
+	va_end(vargs);
+	return strBuf.curLen;
+}
+
+int SafePrintfToSinkOps(PrintfSink& sink, const PrintfOp *ops, const char *format, ...) noexcept
+{
+	va_list vargs;
+	va_start(vargs, format);
+	char batch[SinkBatchSize + 1];
+	SStringBuf strBuf(batch, sizeof(batch), &sink);
+	tiny_print(strBuf, format, ops, vargs);
+	va_end(vargs);
+	if (strBuf.sink != nullptr)
+	{
+		(void)strBuf.Flush();
+	}
+	return strBuf.curLen;
+}
+
 // End
@@ -10,10 +10,183 @@
 
 #include <cstdarg>
 #include <cstddef>
+#include <cstdint>
 
 int SafeVsnprintf(char *buffer, size_t maxLen, const char *format, va_list args) noexcept;
 int SafeSnprintf(char* buffer, size_t maxLen, const char* format, ...) noexcept __attribute__ ((format (printf, 3, 4)));
 
+// Interface for a destination that receives formatted output in batches of characters, so that we can format directly into it without an intermediate buffer
+class PrintfSink
+{
+public:
+	// Accept a batch of characters, which is not null-terminated. Return false if they could not be accepted, which stops further output.
+	virtual bool Write(const char *s, size_t len) noexcept = 0;
+
+protected:
+	~PrintfSink() noexcept { }
+};
+
+// Maximum number of characters that SafeVprintfToSink passes to the sink in a single call
+constexpr size_t SinkBatchSize = 32;
+
+// Format into a sink, returning the number of characters that the sink accepted
+int SafeVprintfToSink(PrintfSink& sink, const char *format, va_list args) noexcept;
+int SafePrintfToSink(PrintfSink& sink, const char *format, ...) noexcept __attribute__ ((format (printf, 2, 3)));
+
+// Pre-parsed format strings.
+// For frequently-used constant formats we can parse the format at compile time into a list of operations, so that at run time we don't need to parse it again.
+// Each operation prints a run of literal text from the format string followed by one conversion.
+struct PrintfOp
+{
+	static constexpr uint8_t PadRight = 0x01, PadZero = 0x02, WidthFromArg = 0x04, LimitFromArg = 0x08, Long32 = 0x10, Long64 = 0x20;
+
+	uint16_t literalStart = 0;				// offset in the format string of the literal text to print before the conversion
+	uint16_t literalLength = 0;				// number of literal characters to print
+	char conversion = 0;					// the conversion character, '%' to print a percent sign, or 0 at the end of the format
+	uint8_t flags = 0;
+	int16_t width = 0;
+	int16_t printLimit = 0;
+};
+
+// Parse a format string into a list of operations, returning the number of operations. If ops is null then just count them.
+// This follows the same rules as the runtime parser in SafeVsnprintf.
+constexpr size_t ParsePrintfFormat(const char *format, PrintfOp *ops) noexcept
+{
+	size_t numOps = 0;
+	size_t i = 0;
+	for (;;)
+	{
+		PrintfOp op;
+		op.literalStart = (uint16_t)i;
+		while (format[i] != '%' && format[i] != 0)
+		{
+			++i;
+		}
+		op.literalLength = (uint16_t)(i - op.literalStart);
+
+		char ch = format[i];
+		if (ch == '%')
+		{
+			ch = format[++i];
+			++i;
+			if (ch == '-')
+			{
+				op.flags |= PrintfOp::PadRight;
+				ch = format[i++];
+			}
+			while (ch == '0')
+			{
+				op.flags |= PrintfOp::PadZero;
+				ch = format[i++];
+			}
+			if (ch == '*')
+			{
+				op.flags |= PrintfOp::WidthFromArg;
+				ch = format[i++];
+			}
+			else
+			{
+				while (ch >= '0' && ch <= '9')
+				{
+					op.width = (int16_t)(op.width * 10 + (ch - '0'));
+					ch = format[i++];
+				}
+			}
+			if (ch == '.')
+			{
+				ch = format[i++];
+				if (ch == '*')
+				{
+					op.flags |= PrintfOp::LimitFromArg;
+					ch = format[i++];
+				}
+				else
+				{
+					while (ch >= '0' && ch <= '9')
+					{
+						op.printLimit = (int16_t)(op.printLimit * 10 + (ch - '0'));
+						ch = format[i++];
+					}
+				}
+			}
+			if (ch == 'l')
+			{
+				ch = format[i++];
+				if (ch == 'l')
+				{
+					op.flags |= PrintfOp::Long64;
+					ch = format[i++];
+				}
+				else
+				{
+					op.flags |= PrintfOp::Long32;
+				}
+			}
+		}
+		op.conversion = ch;
+		if (ops != nullptr)
+		{
+			ops[numOps] = op;
+		}
+		++numOps;
+		if (ch == 0)
+		{
+			return numOps;					// end of the format string, possibly in the middle of an incomplete conversion
+		}
+	}
+}
+
+constexpr size_t CountPrintfOps(const char *format) noexcept
+{
+	return ParsePrintfFormat(format, nullptr);
+}
+
+template<size_t NumOps> class PreparsedFormat
+{
+public:
+	explicit constexpr PreparsedFormat(const char *fmt) noexcept : format(fmt), ops{} { (void)ParsePrintfFormat(fmt, ops); }
+
+	const char *format;
+	PrintfOp ops[NumOps];
+};
+
+// Format using a list of operations returned by ParsePrintfFormat. The format string must be the one that the operations were parsed from.
+int SafeSnprintfOps(char *buffer, size_t maxLen, const PrintfOp *ops, const char *format, ...) noexcept;
+int SafePrintfToSinkOps(PrintfSink& sink, const PrintfOp *ops, const char *format, ...) noexcept;
+
+// Format using a pre-parsed format. The arguments are not checked against the format, so normally you should use the SafeSnprintfPreparsed macro instead.
+template<size_t NumOps, class... Args> inline int SafeSnprintf(char *buffer, size_t maxLen, const PreparsedFormat<NumOps>& fmt, Args... args) noexcept
+{
+	return SafeSnprintfOps(buffer, maxLen, fmt.ops, fmt.format, args...);
+}
+
+template<size_t NumOps, class... Args> inline int SafePrintfToSink(PrintfSink& sink, const PreparsedFormat<NumOps>& fmt, Args... args) noexcept
+{
+	return SafePrintfToSinkOps(sink, fmt.ops, fmt.format, args...);
+}
+
+// Dummy function used to get the compiler to check the arguments against a format that we pre-parse. It is never called.
+inline void CheckPrintfFormat(const char *format, ...) noexcept __attribute__ ((format (printf, 1, 2)));
+inline void CheckPrintfFormat(const char *, ...) noexcept { }
+
+// Macros to format using a string literal that is parsed at compile time, with the usual checking of the arguments against the format. For example:
+//   SafeSnprintfPreparsed(buf, sizeof(buf), "X:%.3f Y:%.3f Z:%.3f", (double)x, (double)y, (double)z);
+#define SafeSnprintfPreparsed(_buf, _maxLen, _fmt, ...) \
+	[&]() noexcept -> int \
+	{ \
+		static constexpr PreparsedFormat<CountPrintfOps(_fmt)> preparsedFormat(_fmt); \
+		if (false) { CheckPrintfFormat(_fmt, ##__VA_ARGS__); } \
+		return SafeSnprintf(_buf, _maxLen, preparsedFormat, ##__VA_ARGS__); \
+	}()
+
+#define SafePrintfToSinkPreparsed(_sink, _fmt, ...) \
+	[&]() noexcept -> int \
+	{ \
+		static constexpr PreparsedFormat<CountPrintfOps(_fmt)> preparsedFormat(_fmt); \
+		if (false) { CheckPrintfFormat(_fmt, ##__VA_ARGS__); } \
+		return SafePrintfToSink(_sink, preparsedFormat, ##__VA_ARGS__); \
+	}()
+
 #define vsnprintf(b, m, f, a) static_assert(false, "Do not use vsnprintf, use SafeVsnprintf instead")
 #define snprintf(b, m, f, ...) static_assert(false, "Do not use snprintf, use SafeSnprintf instead")
 
@@ -17,6 +17,7 @@ public:
 	String() noexcept { storage[0] = 0; }
 
 	StringRef GetRef() noexcept { return StringRef(storage, Len + 1); }
+	CachedLengthStringRef GetCachedLengthRef() noexcept { return CachedLengthStringRef(storage, Len + 1); }	// use this when appending many times
 	const char *c_str() const noexcept { return storage; }
 	size_t strlen() const noexcept { return Strnlen(storage, Len); }
 	bool IsEmpty() const noexcept { return storage[0] == 0; }
@@ -39,13 +40,14 @@ public:
 	bool Prepend(const char *src) noexcept;								// returns true if buffer is too small
 
 	void CopyAndPad(const char *src) noexcept;
-	bool ConstantTimeEquals(String<Len> other) const noexcept;
+	bool ConstantTimeEquals(const String<Len>& other) const noexcept;
 
 	void Truncate(size_t len) noexcept;
 	void Erase(size_t pos, size_t count = 1) noexcept;
 	bool Insert(size_t pos, char c) noexcept { return GetRef().Insert(pos, c); }		// returns true if buffer is too small
 	bool Insert(size_t pos, const char *s) noexcept { return GetRef().Insert(pos, s); }	// returns true if buffer is too small
 	bool Equals(const char *s) const noexcept { return strcmp(storage, s) == 0; }
+	bool Equals(const String<Len>& other) const noexcept;
 	bool EqualsIgnoreCase(const char *s) const noexcept { return StringEqualsIgnoreCase(storage, s); }
 	int Contains(const char *s) const noexcept;
 	int Contains(char c) const noexcept;
@@ -54,7 +56,11 @@ public:
 	void EnsureNullTerminated() noexcept { storage[Len] = 0; }
 
 private:
-	char storage[Len + 1];
+	typedef uint32_t Word;
+
+	Word GetWord(size_t index) const noexcept { Word w; memcpy(&w, storage + index, sizeof(w)); return w; }
+
+	alignas(Word) char storage[Len + 1];				// aligned so that we can compare strings a word at a time
 };
 
 // Copy some text into this string and pad it with nulls so we can do a constant time compare
@@ -65,16 +71,40 @@ template<size_t Len> void String<Len>::CopyAndPad(const char* src) noexcept
 }
 
 // Do a constant time compare. Both this string and the other one much be padded with nulls.
-template<size_t Len> bool String<Len>::ConstantTimeEquals(String<Len> other) const noexcept
+template<size_t Len> bool String<Len>::ConstantTimeEquals(const String<Len>& other) const noexcept
 {
-	char rslt = 0;
-	for (size_t i = 0; i < Len; ++i)
+	Word rslt = 0;
+	size_t i = 0;
+	for (; i + sizeof(Word) <= Len; i += sizeof(Word))
+	{
+		rslt |= GetWord(i) ^ other.GetWord(i);
+	}
+	for (; i < Len; ++i)
 	{
-		rslt |= (storage[i] ^ other.storage[i]);
+		rslt |= (uint8_t)(storage[i] ^ other.storage[i]);
 	}
 	return rslt == 0;
 }
 
+// Compare with another string of the same type. This is fastest when both strings are padded with nulls, but works whether they are or not.
+template<size_t Len> bool String<Len>::Equals(const String<Len>& other) const noexcept
+{
+	size_t i = 0;
+	for (; i + sizeof(Word) <= Len + 1; i += sizeof(Word))
+	{
+		const Word w = GetWord(i);
+		if (w != other.GetWord(i))
+		{
+			break;											// the strings differ here, or one of them ends here and isn't padded
+		}
+		if (((w - 0x01010101u) & ~w & 0x80808080u) != 0)
+		{
+			return true;									// both strings end in this word
+		}
+	}
+	return strncmp(storage + i, other.storage + i, Len + 1 - i) == 0;
+}
+
 template<size_t Len> inline int String<Len>::vprintf(const char *fmt, va_list vargs) noexcept
 {
 	return GetRef().vprintf(fmt, vargs);
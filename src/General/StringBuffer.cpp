@@ -15,6 +15,16 @@ bool StringBuffer::Fix() noexcept
 	{
 		used += slen + 1;
 		p[used] = 0;
+		UpdateHighWater();
+		return false;
+	}
+
+	// The string fills the rest of the storage, so there is no room for another one. Carry on in the overflow chunk if we have one.
+	if (CanOverflow())
+	{
+		StartOverflow(used + slen + 1);
+		p[0] = 0;
+		UpdateHighWater();
 		return false;
 	}
 	return true;
@@ -40,11 +50,11 @@ bool StringBuffer::Concat(const char *s1, const char *s2) noexcept
 	{
 		// s1 is the last string in the buffer
 		used -= s1Len + 1;
-		return GetRef().cat(s2);
+		return EnsureSpace(s1Len + s2LenPlusOne - 1) || GetRef().cat(s2);
 	}
 
 	// No optimisation possible
-	return GetRef().copy(s1) || GetRef().cat(s2);
+	return EnsureSpace(s1Len + s2LenPlusOne - 1) || GetRef().copy(s1) || GetRef().cat(s2);
 }
 
 // The is called when we have finished using a string, which may be in the buffer. If it is the last string in the buffer, we can delete it.
@@ -58,4 +68,72 @@ void StringBuffer::FinishedUsing(const char *s) noexcept
 	}
 }
 
+// Reset the buffer to be empty
+void StringBuffer::Reset() noexcept
+{
+	p = primaryP;
+	len = primaryLen;
+	used = 0;
+	inOverflow = false;
+	*p = 0;
+}
+
+// Discard the latest string and all strings fixed since the mark was taken.
+// Marks must be used in last-in, first-out order, and a mark taken before a call to Reset must not be used after it.
+void StringBuffer::Rollback(Mark m) noexcept
+{
+	if (inOverflow && !m.inOverflow)
+	{
+		// The mark was taken before we started using the overflow chunk, so we can go back to the main storage
+		p = primaryP;
+		len = primaryLen;
+		used = m.used;
+		inOverflow = false;
+	}
+	else if (m.inOverflow == inOverflow && m.used <= used)
+	{
+		used = m.used;
+	}
+	p[used] = 0;
+}
+
+// Make sure that the latest string can grow to at least 'needed' characters, if necessary by moving it to the overflow chunk. Return true if insufficient space.
+bool StringBuffer::EnsureSpace(size_t needed) noexcept
+{
+	if (needed < len - used)
+	{
+		return false;
+	}
+	if (!CanOverflow() || needed >= overflowLen)
+	{
+		return true;
+	}
+
+	const char * const latest = p + used;
+	const size_t latestLen = strlen(latest);
+	StartOverflow(used);
+	memcpy(p, latest, latestLen + 1);					// this fits because latestLen < len - used <= needed < overflowLen
+	return false;
+}
+
+// Start using the overflow chunk, recording how much of the main storage we have used
+void StringBuffer::StartOverflow(size_t newPrimaryUsed) noexcept
+{
+	primaryUsed = newPrimaryUsed;
+	p = overflowP;
+	len = overflowLen;
+	used = 0;
+	inOverflow = true;
+	++numOverflows;
+}
+
+void StringBuffer::UpdateHighWater() noexcept
+{
+	const size_t totalUsed = (inOverflow) ? primaryUsed + used : used;
+	if (totalUsed > highWater)
+	{
+		highWater = totalUsed;
+	}
+}
+
 // End
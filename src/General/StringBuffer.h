@@ -11,10 +11,23 @@
 #include "StringRef.h"
 
 // Class to define a buffer that can hold multiple strings
+// Optionally the buffer can be given a second chunk of storage to use when the first one is full. Strings already fixed in the first chunk remain valid when we start using it.
 class StringBuffer
 {
 public:
-	StringBuffer(char *pp, size_t pl) noexcept : p(pp), len(pl), used(0) { *p = 0; }
+	// Class to record the state of the buffer so that we can later discard all the strings created since then
+	class Mark
+	{
+		friend class StringBuffer;
+		size_t used;
+		bool inOverflow;
+	};
+
+	StringBuffer(char *pp, size_t pl) noexcept
+		: p(pp), len(pl), used(0),
+		  primaryP(pp), primaryLen(pl), primaryUsed(0), overflowP(nullptr), overflowLen(0),
+		  highWater(0), numOverflows(0), inOverflow(false)
+	{ *p = 0; }
 
 	// Get a StringRef to the latest string in the buffer
 	StringRef GetRef() const noexcept { return StringRef(p + used, len - used); }
@@ -36,14 +49,61 @@ public:
 	void FinishedUsing(const char *s) noexcept;
 
 	// Reset the buffer to be empty
-	void Reset() noexcept { used = 0; }
+	void Reset() noexcept;
+
+	// Get a mark that can be passed to Rollback later
+	Mark GetMark() const noexcept { Mark m; m.used = used; m.inOverflow = inOverflow; return m; }
+
+	// Discard the latest string and all strings fixed since the mark was taken, in constant time
+	void Rollback(Mark m) noexcept;
+
+	// Provide a chunk of storage to use when the main one is full. It is only used between calls to Reset.
+	void SetOverflowChunk(char *pp, size_t pl) noexcept { overflowP = pp; overflowLen = pl; }
+
+	// Make sure that the latest string can grow to at least 'needed' characters, if necessary by moving it to the overflow chunk. Return true if insufficient space.
+	bool EnsureSpace(size_t needed) noexcept;
+
+	// Statistics
+	size_t GetHighWater() const noexcept { return highWater; }			// the highest number of characters that fixed strings have occupied
+	unsigned int GetNumOverflows() const noexcept { return numOverflows; }	// the number of times we have started using the overflow chunk
+	void ResetStatistics() noexcept { highWater = 0; numOverflows = 0; }
 
 private:
-	char *p;				// pointer to the storage
-	size_t len;				// number of characters in the storage, must be at least 1
-	size_t used;			// how much of the buffer we have used so far
+	bool CanOverflow() const noexcept { return !inOverflow && overflowP != nullptr && overflowLen != 0; }
+	void StartOverflow(size_t newPrimaryUsed) noexcept;
+	void UpdateHighWater() noexcept;
+
+	char *p;				// pointer to the storage currently in use
+	size_t len;				// number of characters in the storage currently in use, must be at least 1
+	size_t used;			// how much of the storage currently in use we have used so far
+
+	char *primaryP;			// the main storage
+	size_t primaryLen;
+	size_t primaryUsed;		// how much of the main storage was used when we started using the overflow chunk
+	char *overflowP;		// the overflow chunk, or nullptr
+	size_t overflowLen;
+
+	size_t highWater;
+	unsigned int numOverflows;
+	bool inOverflow;		// true if p and len refer to the overflow chunk
 
 	// invariant(used < len)
 };
 
+// Class to discard all the strings created in a StringBuffer while an object of this class is in scope.
+// Any result that is needed after the end of the scope must be copied elsewhere before then.
+class StringBufferRollback
+{
+public:
+	explicit StringBufferRollback(StringBuffer& p_buf) noexcept : buf(p_buf), mark(p_buf.GetMark()) { }
+	~StringBufferRollback() noexcept { buf.Rollback(mark); }
+
+	StringBufferRollback(const StringBufferRollback&) = delete;
+	StringBufferRollback& operator=(const StringBufferRollback&) = delete;
+
+private:
+	StringBuffer& buf;
+	StringBuffer::Mark mark;
+};
+
 #endif /* SRC_GENERAL_STRINGBUFFER_H_ */
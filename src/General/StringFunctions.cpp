@@ -9,6 +9,48 @@
 #include <cstring>
 #include <cctype>
 
+// Functions to process strings a word at a time.
+// We only read whole words from word-aligned addresses, so although we may read a few bytes beyond the null at the end of a string, we never read past the end of the memory region that holds it.
+// We can only do this for two strings at once when they have the same alignment, so if they don't then we process them a byte at a time.
+
+typedef uint32_t StringWord;
+constexpr size_t StringWordSize = sizeof(StringWord);
+constexpr StringWord BytesOf(uint8_t b) noexcept { return 0x01010101u * b; }
+
+static inline bool IsWordAligned(const char *p) noexcept
+{
+	return ((uintptr_t)p & (StringWordSize - 1)) == 0;
+}
+
+static inline StringWord LoadWord(const char *p) noexcept
+{
+	StringWord w;
+	memcpy(&w, __builtin_assume_aligned(p, StringWordSize), sizeof(w));
+	return w;
+}
+
+// Return nonzero if any byte in the word is zero
+static inline StringWord HasZeroByte(StringWord w) noexcept
+{
+	return (w - BytesOf(0x01)) & ~w & BytesOf(0x80);
+}
+
+// Return nonzero if any byte in the word is equal to b
+static inline StringWord HasByte(StringWord w, uint8_t b) noexcept
+{
+	return HasZeroByte(w ^ BytesOf(b));
+}
+
+// Convert the upper case ASCII letters in a word to lower case, leaving all other bytes unchanged. This gives the same results as tolower in the C locale.
+static inline StringWord WordToLower(StringWord w) noexcept
+{
+	const StringWord lowBits = w & BytesOf(0x7F);
+	const StringWord aboveZ = lowBits + BytesOf(0x7F - 'Z');			// top bit of each byte set if the byte is above 'Z'
+	const StringWord atLeastA = lowBits + BytesOf(0x80 - 'A');			// top bit of each byte set if the byte is 'A' or above
+	const StringWord isUpper = (atLeastA ^ aboveZ) & ~w & BytesOf(0x80);	// excluding bytes with the top bit set, which aren't ASCII
+	return w | (isUpper >> 2);
+}
+
 bool StringEndsWithIgnoreCase(const char* string, const char* ending) noexcept
 {
 	const size_t j = strlen(string);
@@ -18,6 +60,38 @@ bool StringEndsWithIgnoreCase(const char* string, const char* ending) noexcept
 
 bool StringEqualsIgnoreCase(const char* s1, const char* s2) noexcept
 {
+	if (((uintptr_t)s1 ^ (uintptr_t)s2) % StringWordSize == 0)
+	{
+		while (!IsWordAligned(s1))
+		{
+			if (tolower(*s1) != tolower(*s2))
+			{
+				return false;
+			}
+			if (*s1 == 0)
+			{
+				return true;
+			}
+			++s1;
+			++s2;
+		}
+
+		for (;;)
+		{
+			const StringWord w1 = LoadWord(s1), w2 = LoadWord(s2);
+			if (HasZeroByte(w1) || HasZeroByte(w2))
+			{
+				break;								// finish off a byte at a time so that we don't compare bytes after the end of the strings
+			}
+			if (w1 != w2 && WordToLower(w1) != WordToLower(w2))
+			{
+				return false;
+			}
+			s1 += StringWordSize;
+			s2 += StringWordSize;
+		}
+	}
+
 	size_t i = 0;
 	while (s1[i] != 0 && s2[i] != 0)
 	{
@@ -33,8 +107,25 @@ bool StringEqualsIgnoreCase(const char* s1, const char* s2) noexcept
 
 bool ReducedStringEquals(const char* s1, const char* s2) noexcept
 {
+	const bool sameAlignment = ((uintptr_t)s1 ^ (uintptr_t)s2) % StringWordSize == 0;
 	while (*s1 != 0 && *s2 != 0)
 	{
+		// If both strings are aligned, compare a word at a time until we reach a null, hyphen or underscore in either of them
+		if (sameAlignment && IsWordAligned(s1) && IsWordAligned(s2))
+		{
+			const StringWord w1 = LoadWord(s1), w2 = LoadWord(s2);
+			if (!HasZeroByte(w1) && !HasZeroByte(w2) && !HasByte(w1, '-') && !HasByte(w2, '-') && !HasByte(w1, '_') && !HasByte(w2, '_'))
+			{
+				if (w1 != w2 && WordToLower(w1) != WordToLower(w2))
+				{
+					return false;
+				}
+				s1 += StringWordSize;
+				s2 += StringWordSize;
+				continue;
+			}
+		}
+
 		if (*s1 == '-' || *s1 == '_')
 		{
 			++s1;
@@ -79,43 +170,89 @@ bool StringStartsWith(const char* string, const char* starting) noexcept
 
 bool StringStartsWithIgnoreCase(const char* string, const char* starting) noexcept
 {
-	const size_t j = strlen(string);
-	const size_t k = strlen(starting);
-	if (k > j)
+	if (((uintptr_t)string ^ (uintptr_t)starting) % StringWordSize == 0)
 	{
-		return false;
+		while (!IsWordAligned(starting))
+		{
+			if (*starting == 0)
+			{
+				return true;
+			}
+			if (tolower(*string) != tolower(*starting))
+			{
+				return false;
+			}
+			++string;
+			++starting;
+		}
+
+		for (;;)
+		{
+			const StringWord w1 = LoadWord(string), w2 = LoadWord(starting);
+			if (HasZeroByte(w2))
+			{
+				break;
+			}
+			if (w1 != w2 && WordToLower(w1) != WordToLower(w2))
+			{
+				return false;						// this includes the case of 'string' ending in this word
+			}
+			string += StringWordSize;
+			starting += StringWordSize;
+		}
 	}
 
-	for (size_t i = 0; i < k; i++)
+	for (size_t i = 0; starting[i] != 0; i++)
 	{
 		if (tolower(string[i]) != tolower(starting[i]))
 		{
-			return false;
+			return false;						// this includes the case of 'string' being shorter than 'starting'
 		}
 	}
 
 	return true;
 }
 
+// Return the index of the first occurrence of 'match' in 'string', or -1 if not found
+// This uses the Boyer-Moore-Horspool algorithm. To save stack space, the table of shifts is indexed by the low 6 bits of the character.
+// Each entry holds the smallest shift for any character that maps to it, which is always safe.
 int StringContains(const char* string, const char* match) noexcept
 {
-	int i = 0;
-	int count = 0;
+	const size_t matchLength = strlen(match);
+	if (matchLength == 0)
+	{
+		return -1;
+	}
+	const size_t stringLength = strlen(string);
+	if (matchLength > stringLength)
+	{
+		return -1;
+	}
 
-	while (string[i] != 0)
+	constexpr size_t ShiftTableSize = 64;
+	const uint8_t maxShift = (matchLength < UINT8_MAX) ? (uint8_t)matchLength : UINT8_MAX;
+	uint8_t shifts[ShiftTableSize];
+	memset(shifts, maxShift, sizeof(shifts));
+	for (size_t i = 0; i + 1 < matchLength; ++i)
 	{
-		if (string[i++] == match[count])
+		const size_t shift = matchLength - 1 - i;
+		uint8_t& entry = shifts[(uint8_t)match[i] % ShiftTableSize];
+		if (shift < entry)
 		{
-			count++;
-			if (match[count] == 0)
-			{
-				return i - count;
-			}
+			entry = (uint8_t)shift;
 		}
-		else
+	}
+
+	const char lastMatchChar = match[matchLength - 1];
+	size_t pos = 0;
+	while (pos <= stringLength - matchLength)
+	{
+		const char c = string[pos + matchLength - 1];
+		if (c == lastMatchChar && memcmp(string + pos, match, matchLength - 1) == 0)
 		{
-			count = 0;
+			return (int)pos;
 		}
+		pos += shifts[(uint8_t)c % ShiftTableSize];
 	}
 
 	return -1;
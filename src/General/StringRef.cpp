@@ -288,4 +288,233 @@ int StringRef::Contains(char c) const noexcept
 	return (r == nullptr) ? -1 : r - p;
 }
 
+//*************************************************************************************************
+// CachedLengthStringRef class member implementations
+
+// Recalculate the length of the string after it has been changed by something else
+void CachedLengthStringRef::Resync() noexcept
+{
+	curLen = Strnlen(p, len - 1);
+	p[curLen] = 0;
+}
+
+int CachedLengthStringRef::printf(const char *fmt, ...) noexcept
+{
+	va_list vargs;
+	va_start(vargs, fmt);
+	const int ret = vprintf(fmt, vargs);
+	va_end(vargs);
+	return ret;
+}
+
+// SafeVsnprintf returns the number of characters actually stored, so we can use it to update the length
+int CachedLengthStringRef::vprintf(const char *fmt, va_list vargs) noexcept
+{
+	const int ret = SafeVsnprintf(p, len, fmt, vargs);
+	curLen = ret;
+	return ret;
+}
+
+int CachedLengthStringRef::catf(const char *fmt, ...) noexcept
+{
+	va_list vargs;
+	va_start(vargs, fmt);
+	const int ret = vcatf(fmt, vargs);
+	va_end(vargs);
+	return ret;
+}
+
+// This is like catf but it adds a newline first if the string being appended to is not empty
+int CachedLengthStringRef::lcatf(const char *fmt, ...) noexcept
+{
+	if (curLen != 0 && cat('\n'))
+	{
+		return 0;
+	}
+	va_list vargs;
+	va_start(vargs, fmt);
+	const int ret = vcatf(fmt, vargs);
+	va_end(vargs);
+	return ret;
+}
+
+int CachedLengthStringRef::vcatf(const char *fmt, va_list vargs) noexcept
+{
+	if (curLen + 1 < len)		// if room for at least 1 more character and a null
+	{
+		curLen += SafeVsnprintf(p + curLen, len - curLen, fmt, vargs);
+		return curLen;
+	}
+	return 0;
+}
+
+bool CachedLengthStringRef::copy(const char* src) noexcept
+{
+	curLen = 0;
+	return AppendChars(src, ::strlen(src));
+}
+
+bool CachedLengthStringRef::copy(const char* src, size_t maxlen) noexcept
+{
+	curLen = 0;
+	return AppendChars(src, Strnlen(src, maxlen));
+}
+
+// Append slen characters to the string, truncating them if there is insufficient room. Return true if they were truncated.
+bool CachedLengthStringRef::AppendChars(const char *src, size_t slen) noexcept
+{
+	const bool overflow = (curLen + slen >= len);
+	const size_t toCopy = (overflow) ? len - curLen - 1 : slen;
+	memcpy(p + curLen, src, toCopy);
+	curLen += toCopy;
+	p[curLen] = 0;
+	return overflow;
+}
+
+bool CachedLengthStringRef::cat(const char* src) noexcept
+{
+	return AppendChars(src, ::strlen(src));
+}
+
+// As cat but add a newline first if the string being appended to is not empty
+bool CachedLengthStringRef::lcat(const char* src) noexcept
+{
+	return (curLen != 0 && cat('\n')) || cat(src);
+}
+
+// Concatenate with a limit on the number of characters read
+bool CachedLengthStringRef::catn(const char *src, size_t n) noexcept
+{
+	return AppendChars(src, Strnlen(src, n));
+}
+
+// As catn but add a newline first if the string being appended to is not empty
+bool CachedLengthStringRef::lcatn(const char *src, size_t n) noexcept
+{
+	return (curLen != 0 && cat('\n')) || catn(src, n);
+}
+
+// Append a character
+bool CachedLengthStringRef::cat(char c) noexcept
+{
+	if (curLen + 1 < len)
+	{
+		p[curLen] = c;
+		++curLen;
+		p[curLen] = 0;
+		return false;
+	}
+	return true;
+}
+
+// Remove trailing spaces from the string and return its new length
+size_t CachedLengthStringRef::StripTrailingSpaces() noexcept
+{
+	while (curLen != 0 && p[curLen - 1] == ' ')
+	{
+		--curLen;
+	}
+	p[curLen] = 0;
+	return curLen;
+}
+
+bool CachedLengthStringRef::Prepend(const char *src) noexcept
+{
+	const size_t slen = ::strlen(src);
+	if (slen + curLen < len)
+	{
+		memmove(p + slen, p, curLen + 1);
+		memcpy(p, src, slen);
+		curLen += slen;
+		return false;
+	}
+	return true;
+}
+
+void CachedLengthStringRef::Truncate(size_t pos) noexcept
+{
+	if (pos < curLen)
+	{
+		p[pos] = 0;
+		curLen = pos;
+	}
+}
+
+void CachedLengthStringRef::Erase(size_t pos, size_t count) noexcept
+{
+	if (pos < curLen)
+	{
+		if (pos + count < curLen)
+		{
+			memmove(p + pos, p + pos + count, curLen - (pos + count));
+			curLen -= count;
+		}
+		else
+		{
+			curLen = pos;
+		}
+		p[curLen] = 0;
+	}
+}
+
+// Insert a character, returning true if the string was truncated
+bool CachedLengthStringRef::Insert(size_t pos, char c) noexcept
+{
+	if (pos > curLen)
+	{
+		return false;										// insert point is out of range, but return success anyway
+	}
+
+	if (curLen + 1 < len)									// check there is space for the existing string + null + inserted character
+	{
+		memmove(p + pos + 1, p + pos, curLen - pos + 1);	// copy the data up including the null terminator
+		p[pos] = c;
+		++curLen;
+		return false;
+	}
+
+	if (pos < curLen)
+	{
+		// The buffer is already full, but we haven't been asked to insert the character right at the end
+		memmove(p + pos + 1, p + pos, curLen - pos - 1);	// leave the null terminator intact and drop the last character
+		p[pos] = c;
+	}
+	return true;
+}
+
+// Insert another string, returning true if the string was truncated
+bool CachedLengthStringRef::Insert(size_t pos, const char *s) noexcept
+{
+	if (pos > curLen)
+	{
+		return false;										// insert point is out of range, but return success anyway
+	}
+
+	const size_t slen2 = ::strlen(s);
+	if (curLen + slen2 < len)								// check there is space for the existing string + null + inserted characters
+	{
+		memmove(p + pos + slen2, p + pos, curLen - pos + 1);	// copy the data up including the null terminator
+		memcpy(p + pos, s, slen2);
+		curLen += slen2;
+		return false;
+	}
+
+	if (pos < curLen)
+	{
+		// The buffer doesn't have enough room, but we haven't been asked to insert the characters right at the end
+		if (pos + slen2 < len)
+		{
+			memmove(p + pos + slen2, p + pos, len - pos - slen2);		// drop the last characters
+			memcpy(p + pos, s, slen2);
+		}
+		else
+		{
+			memcpy(p + pos, s, len - pos - 1);				// we can only copy part of the inserted string
+		}
+		curLen = len - 1;
+		p[curLen] = 0;
+	}
+	return true;
+}
+
 // End
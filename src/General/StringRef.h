@@ -59,4 +59,61 @@ public:
 	int Contains(char c) const noexcept;
 };
 
+// Class to describe a string buffer that keeps track of the length of the string in it, so that appending to the string doesn't need to find the end of it first.
+// Use this when building a long string a piece at a time, for example a JSON response, to avoid the time taken growing with the square of the length.
+// Unlike StringRef, this must not be copied while it is in use, because each copy would have its own record of the length.
+// If the string is changed other than through this object, for example by passing the result of GetRef() to a function that modifies the string, call Resync() afterwards.
+class CachedLengthStringRef
+{
+	char *p;				// pointer to the storage
+	size_t len;				// number of characters in the storage, must be at least 1
+	size_t curLen;			// length of the string currently in the storage
+
+	bool AppendChars(const char *src, size_t slen) noexcept;
+
+public:
+	// Construct from a buffer that already contains a string. If it isn't null-terminated, the string is truncated to fit.
+	CachedLengthStringRef(char *pp, size_t pl) noexcept : p(pp), len(pl) { Resync(); }
+	explicit CachedLengthStringRef(const StringRef& ref) noexcept : CachedLengthStringRef(ref.Pointer(), ref.Capacity() + 1) { }
+
+	CachedLengthStringRef(const CachedLengthStringRef&) = delete;
+	CachedLengthStringRef& operator=(const CachedLengthStringRef&) = delete;
+
+	StringRef GetRef() const noexcept { return StringRef(p, len); }
+	void Resync() noexcept;
+
+	size_t Capacity() const noexcept { return len - 1; }
+	size_t strlen() const noexcept { return curLen; }
+	bool IsEmpty() const noexcept { return curLen == 0; }
+	bool IsFull() const noexcept { return curLen + 1 == len; }
+
+	const char *c_str() const noexcept { return p; }
+	char operator[](size_t index) const noexcept { return p[index]; }
+
+	void Clear() noexcept { p[0] = 0; curLen = 0; }
+
+	int printf(const char *fmt, ...) noexcept __attribute__ ((format (printf, 2, 3)));
+	int vprintf(const char *fmt, va_list vargs) noexcept;
+	int catf(const char *fmt, ...) noexcept __attribute__ ((format (printf, 2, 3)));
+	int lcatf(const char *fmt, ...) noexcept __attribute__ ((format (printf, 2, 3)));
+	int vcatf(const char *fmt, va_list vargs) noexcept;
+	bool copy(const char* src) noexcept;							// returns true if buffer is too small
+	bool copy(const char *src, size_t maxlen) noexcept;				// returns true if buffer is too small
+	bool cat(const char *src) noexcept;								// returns true if buffer is too small
+	bool lcat(const char *src) noexcept;							// returns true if buffer is too small
+	bool catn(const char *src, size_t n) noexcept;					// returns true if buffer is too small
+	bool lcatn(const char *src, size_t n) noexcept;					// returns true if buffer is too small
+	bool cat(char c) noexcept;										// returns true if buffer is too small
+	size_t StripTrailingSpaces() noexcept;
+	bool Prepend(const char *src) noexcept;							// returns true if buffer is too small
+	void Truncate(size_t pos) noexcept;
+	void Erase(size_t pos, size_t count = 1) noexcept;
+	bool Insert(size_t pos, char c) noexcept;						// returns true if buffer is too small
+	bool Insert(size_t pos, const char *s) noexcept;				// returns true if buffer is too small
+	bool Equals(const char *s) const noexcept { return strcmp(p, s) == 0; }
+	bool EqualsIgnoreCase(const char *s) const noexcept { return StringEqualsIgnoreCase(p, s); }
+	int Contains(const char *s) const noexcept { return GetRef().Contains(s); }
+	int Contains(char c) const noexcept { return GetRef().Contains(c); }
+};
+
 #endif /* STRINGREF_H_ */
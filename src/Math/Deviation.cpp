@@ -28,4 +28,42 @@ void Deviation::Set(float sumOfSquares, float sum, size_t numPoints) noexcept
 	}
 }
 
+void DeviationAccumulator::Clear() noexcept
+{
+	numPoints = 0;
+	mean = sumOfSquaredDifferences = minVal = maxVal = 0.0;
+}
+
+void DeviationAccumulator::Add(float val) noexcept
+{
+	++numPoints;
+	if (numPoints == 1)
+	{
+		minVal = maxVal = val;
+	}
+	else if (val < minVal)
+	{
+		minVal = val;
+	}
+	else if (val > maxVal)
+	{
+		maxVal = val;
+	}
+
+	const float delta = val - mean;
+	mean += delta/numPoints;
+	sumOfSquaredDifferences += delta * (val - mean);
+}
+
+float DeviationAccumulator::GetDeviationFromMean() const noexcept
+{
+	return sqrtf(GetVariance());
+}
+
+// Return the root mean square value, using: mean of squares = variance + mean squared
+float DeviationAccumulator::GetRms() const noexcept
+{
+	return sqrtf(GetVariance() + mean * mean);
+}
+
 // End
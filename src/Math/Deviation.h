@@ -17,6 +17,7 @@ public:
 	Deviation() noexcept;
 
 	void Set(float sumOfSquares, float sum, size_t numPoints) noexcept;
+	void SetMeanAndDeviation(float p_mean, float p_deviationFromMean) noexcept { mean = p_mean; deviationFromMean = p_deviationFromMean; }
 
 	float GetMean() const noexcept { return mean; }
 	float GetDeviationFromMean() const noexcept { return deviationFromMean; }
@@ -26,4 +27,31 @@ private:
 	float deviationFromMean;
 };
 
+// Class to accumulate the statistics of a stream of values in a single pass, using Welford's algorithm.
+// This doesn't suffer from the loss of precision that happens when we subtract the square of the mean from the mean of the squares.
+class DeviationAccumulator
+{
+public:
+	DeviationAccumulator() noexcept { Clear(); }
+
+	void Clear() noexcept;
+	void Add(float val) noexcept;
+
+	size_t GetNumPoints() const noexcept { return numPoints; }
+	float GetMean() const noexcept { return mean; }
+	float GetVariance() const noexcept { return (numPoints == 0) ? 0.0 : sumOfSquaredDifferences/numPoints; }
+	float GetDeviationFromMean() const noexcept;
+	float GetRms() const noexcept;
+	float GetMin() const noexcept { return minVal; }			// only valid if at least one value has been added
+	float GetMax() const noexcept { return maxVal; }			// only valid if at least one value has been added
+	void GetDeviation(Deviation& dev) const noexcept { dev.SetMeanAndDeviation(mean, GetDeviationFromMean()); }
+
+private:
+	size_t numPoints;
+	float mean;
+	float sumOfSquaredDifferences;		// sum of the squares of the differences from the current mean
+	float minVal;
+	float maxVal;
+};
+
 #endif /* SRC_MATH_DEVIATION_H_ */
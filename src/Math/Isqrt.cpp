@@ -1,32 +1,84 @@
-#include <cstdint>
+#include "Isqrt.h"
+#include <cmath>
 
-// Fast 62-bit integer square root function (thanks dmould)
-uint32_t isqrt64(uint64_t num) noexcept
+// Fast 32-bit integer square root function - thanks to Wilco Dijkstra for this efficient ARM algorithm
+uint32_t isqrt32(uint32_t num32) noexcept
 {
-	uint32_t numHigh = (uint32_t)(num >> 32);
-	if (numHigh == 0)
+	uint32_t res = 0;
+
+#define iter32(N)						\
+	{									\
+		uint32_t temp = res | (1 << N);	\
+		if (num32 >= temp << N)			\
+		{								\
+			num32 -= temp << N;			\
+			res |= 2 << N;				\
+		}								\
+	}
+
+	// We need to do 16 iterations
+	iter32(15); iter32(14); iter32(13); iter32(12);
+	iter32(11); iter32(10); iter32(9); iter32(8);
+	iter32(7); iter32(6); iter32(5); iter32(4);
+	iter32(3); iter32(2); iter32(1); iter32(0);
+
+#undef iter32
+
+	return res >> 1;
+}
+
+// 32-bit integer square root that uses the number of leading zeros to skip the iterations that can't produce a result bit.
+// This is faster than isqrt32 when the input is usually small.
+uint32_t isqrt32Normalised(uint32_t num) noexcept
+{
+	if (num == 0)
 	{
-		// 32-bit square root - thanks to Wilco Dijkstra for this efficient ARM algorithm
-		uint32_t num32 = (uint32_t)num;
-		uint32_t res = 0;
+		return 0;
+	}
 
-		#define iter32(N)						\
-		{										\
-			uint32_t temp = res | (1 << N);		\
-			if (num32 >= temp << N)				\
-			{									\
-				num32 -= temp << N;				\
-				res |= 2 << N;					\
-			}									\
+	uint32_t res = 0;
+	for (uint32_t bit = 1u << ((31 - __builtin_clz(num)) & ~1u); bit != 0; bit >>= 2)		// start with the highest power of 4 that is not greater than num
+	{
+		if (num >= res + bit)
+		{
+			num -= res + bit;
+			res = (res >> 1) + bit;
 		}
+		else
+		{
+			res >>= 1;
+		}
+	}
+	return res;
+}
 
-		// We need to do 16 iterations
-		iter32(15); iter32(14); iter32(13); iter32(12);
-		iter32(11); iter32(10); iter32(9); iter32(8);
-		iter32(7); iter32(6); iter32(5); iter32(4);
-		iter32(3); iter32(2); iter32(1); iter32(0);
+// 32-bit integer square root seeded from the floating point square root, for processors with a FPU.
+// The seed is within 1 of the true result, then we correct it so that the result is exact.
+uint32_t isqrt32Fpu(uint32_t num) noexcept
+{
+	uint32_t res = (uint32_t)sqrtf((float)num);
+	if (res > 0xFFFF)
+	{
+		res = 0xFFFF;									// the result can't be more than this, and it stops res * res overflowing
+	}
+	while (res * res > num)
+	{
+		--res;
+	}
+	while (res < 0xFFFF && (res + 1) * (res + 1) <= num)
+	{
+		++res;
+	}
+	return res;
+}
 
-		return res >> 1;
+// Fast 62-bit integer square root function (thanks dmould)
+uint32_t isqrt64(uint64_t num) noexcept
+{
+	uint32_t numHigh = (uint32_t)(num >> 32);
+	if (numHigh == 0)
+	{
+		return isqrt32((uint32_t)num);
 	}
 	else if ((numHigh & (3u << 30)) != 0)
 	{
@@ -86,4 +138,32 @@ uint32_t isqrt64(uint64_t num) noexcept
 	}
 }
 
+// 62-bit integer square root seeded from the floating point square root, for processors with a FPU.
+// The float seed may be out by up to about 2^7, so we do one Newton-Raphson step using floating point division, which leaves it within 1 of the true result.
+// Then we correct it so that the result is exact.
+uint32_t isqrt64Fpu(uint64_t num) noexcept
+{
+	if ((num >> 62) != 0)
+	{
+		return 0xFFFFFFFF;								// input out of range - probably negative, so return -1 as isqrt64 does
+	}
+	if ((num >> 32) == 0)
+	{
+		return isqrt32Fpu((uint32_t)num);
+	}
+
+	uint32_t res = (uint32_t)sqrtf((float)num);		// num is at least 2^32 so res is at least 2^16
+	const int64_t error = (int64_t)(num - (uint64_t)res * res);
+	res = (uint32_t)((int64_t)res + lrintf((float)error/(2.0f * (float)res)));
+	while ((uint64_t)res * res > num)
+	{
+		--res;
+	}
+	while ((uint64_t)(res + 1) * (res + 1) <= num)
+	{
+		++res;
+	}
+	return res;
+}
+
 // End
@@ -12,4 +12,10 @@
 
 extern uint32_t isqrt64(uint64_t num) noexcept;		// This is defined in its own file, Isqrt.cpp or Isqrt.asm
 
+// Other integer square root functions, defined in Isqrt.cpp. They all return the exact integer part of the square root.
+extern uint32_t isqrt32(uint32_t num) noexcept;
+extern uint32_t isqrt32Normalised(uint32_t num) noexcept;		// faster than isqrt32 for small inputs
+extern uint32_t isqrt32Fpu(uint32_t num) noexcept;				// for processors with a FPU
+extern uint32_t isqrt64Fpu(uint64_t num) noexcept;				// for processors with a FPU, returns 0xFFFFFFFF if the input has more than 62 bits like isqrt64 does
+
 #endif /* SRC_LIBRARIES_MATH_ISQRT_H_ */
@@ -9,8 +9,73 @@
 #define MATRIX_H_
 
 #include <cstddef>		// for size_t
+#include <cmath>
 #include "../General/ecv.h"
 
+// Operations on rows of a matrix, used in the inner loops of the solvers.
+// The rows must not overlap. They are simple loops over restrict-qualified pointers, so that the compiler can unroll or vectorise them.
+template<class T> inline void RowMultiplySubtract(T * __restrict__ dst, const T * __restrict__ src, T factor, size_t n) noexcept
+{
+	for (size_t k = 0; k < n; ++k)
+	{
+		dst[k] -= src[k] * factor;
+	}
+}
+
+template<class T> inline void RowScale(T * __restrict__ row, T factor, size_t n) noexcept
+{
+	for (size_t k = 0; k < n; ++k)
+	{
+		row[k] *= factor;
+	}
+}
+
+template<class T> inline T RowDotProduct(const T * __restrict__ a, const T * __restrict__ b, size_t n) noexcept
+{
+	T sum = (T)0.0;
+	for (size_t k = 0; k < n; ++k)
+	{
+		sum += a[k] * b[k];
+	}
+	return sum;
+}
+
+// Non-virtual view of a matrix stored in row-major order, so that functions that work with any size of matrix don't need to make a virtual call per element.
+// Use MatrixView<const T> for a read-only view.
+template<class T> class MatrixView
+{
+public:
+	MatrixView(T *p_data, size_t p_rows, size_t p_cols, size_t p_stride) noexcept : data(p_data), numRows(p_rows), numCols(p_cols), stride(p_stride) { }
+
+	size_t rows() const noexcept { return numRows; }
+	size_t cols() const noexcept { return numCols; }
+
+	T& operator() (size_t r, size_t c) const noexcept
+	pre(r < numRows; c < numCols)
+	{
+		return data[r * stride + c];
+	}
+
+	T* GetRow(size_t r) const noexcept
+	pre(r < numRows)
+	{
+		return data + r * stride;
+	}
+
+	// Get a view of part of this matrix
+	MatrixView<T> SubMatrix(size_t firstRow, size_t firstCol, size_t p_rows, size_t p_cols) const noexcept
+	pre(firstRow + p_rows <= numRows; firstCol + p_cols <= numCols)
+	{
+		return MatrixView<T>(data + firstRow * stride + firstCol, p_rows, p_cols, stride);
+	}
+
+private:
+	T *data;
+	size_t numRows;
+	size_t numCols;
+	size_t stride;				// distance between the starts of consecutive rows
+};
+
 // Base class for matrices, allows us to write functions that work with any size matrix
 template<class T> class MathMatrix
 {
@@ -51,6 +116,15 @@ public:
 	pre(numRows <= ROWS; numRows < numCols; numCols <= COLS)
 	;
 
+	// Alternatives to GaussJordan that leave the solutions in the same place, but leave the left hand part of the matrix in an undefined state
+	bool LUSolve(size_t numRows, size_t numCols) noexcept
+	pre(numRows <= ROWS; numRows < numCols; numCols <= COLS)
+	;
+
+	bool CholeskySolve(size_t numRows, size_t numCols) noexcept
+	pre(numRows <= ROWS; numRows < numCols; numCols <= COLS)
+	;
+
 	// Return a pointer to a specified row, non-const version
 	T* GetRow(size_t r) noexcept
 	pre(r < ROWS)
@@ -65,6 +139,10 @@ public:
 		return data[r];
 	}
 
+	// Get a non-virtual view of the matrix
+	MatrixView<T> GetView() noexcept { return MatrixView<T>(&data[0][0], ROWS, COLS, COLS); }
+	MatrixView<const T> GetView() const noexcept { return MatrixView<const T>(&data[0][0], ROWS, COLS, COLS); }
+
 	// Set all elements to a specified value
 	void Fill(T val) noexcept;
 
@@ -114,20 +192,14 @@ template<class T, size_t ROWS, size_t COLS> bool FixedMatrix<T, ROWS, COLS>::Gau
 		{
 			const T factor = data[j][i]/v;
 			data[j][i] = (T)0.0;
-			for (size_t k = i + 1; k < numCols; ++k)
-			{
-				data[j][k] -= data[i][k] * factor;
-			}
+			RowMultiplySubtract(data[j] + i + 1, data[i] + i + 1, factor, numCols - (i + 1));
 		}
 
 		for (size_t j = i + 1; j < numRows; ++j)
 		{
 			const T factor = data[j][i]/v;
 			data[j][i] = (T)0.0;
-			for (size_t k = i + 1; k < numCols; ++k)
-			{
-				data[j][k] -= data[i][k] * factor;
-			}
+			RowMultiplySubtract(data[j] + i + 1, data[i] + i + 1, factor, numCols - (i + 1));
 		}
 	}
 
@@ -144,6 +216,133 @@ template<class T, size_t ROWS, size_t COLS> bool FixedMatrix<T, ROWS, COLS>::Gau
 	return true;
 }
 
+// Solve a N x (N+M) matrix by Gaussian elimination with partial pivoting, which is equivalent to LU decomposition followed by substitution.
+// This does about two thirds of the arithmetic that GaussJordan does, and instead of swapping rows it keeps a permutation index.
+// Return true if successful, false if not possible. On success, columns numRows to numCols-1 hold the solutions as they do after calling GaussJordan.
+template<class T, size_t ROWS, size_t COLS> bool FixedMatrix<T, ROWS, COLS>::LUSolve(size_t numRows, size_t numCols) noexcept
+{
+	size_t perm[ROWS];				// perm[i] is the number of the row that we are using as row i
+	for (size_t i = 0; i < numRows; ++i)
+	{
+		perm[i] = i;
+	}
+
+	// Reduce the matrix to upper triangular form
+	for (size_t i = 0; i < numRows; ++i)
+	{
+		size_t best = i;
+		T vmax = std::fabs(data[perm[i]][i]);
+		for (size_t j = i + 1; j < numRows; ++j)
+		{
+			const T rmax = std::fabs(data[perm[j]][i]);
+			if (rmax > vmax)
+			{
+				best = j;
+				vmax = rmax;
+			}
+		}
+		const size_t temp = perm[i];
+		perm[i] = perm[best];
+		perm[best] = temp;
+
+		const T * const pivotRow = data[perm[i]];
+		const T v = pivotRow[i];
+		if (v == (T)0.0)
+		{
+			return false;
+		}
+
+		for (size_t j = i + 1; j < numRows; ++j)
+		{
+			T * const row = data[perm[j]];
+			const T factor = row[i]/v;
+			row[i] = (T)0.0;
+			RowMultiplySubtract(row + i + 1, pivotRow + i + 1, factor, numCols - (i + 1));
+		}
+	}
+
+	// Back substitute, then put the solutions in the rows they belong in
+	for (size_t c = numRows; c < numCols; ++c)
+	{
+		T solution[ROWS];
+		for (size_t i = numRows; i != 0; )
+		{
+			--i;
+			const T * const row = data[perm[i]];
+			T sum = row[c];
+			for (size_t k = i + 1; k < numRows; ++k)
+			{
+				sum -= row[k] * solution[k];
+			}
+			solution[i] = sum/row[i];
+		}
+		for (size_t i = 0; i < numRows; ++i)
+		{
+			data[i][c] = solution[i];
+		}
+	}
+
+	return true;
+}
+
+// Solve a N x (N+M) matrix whose left hand N x N part is symmetric and positive definite, e.g. the normal equations of a least squares fit.
+// Only the elements on and below the diagonal of the left hand part are used. It is replaced by its Cholesky factor.
+// Return true if successful, false if the matrix is not positive definite. On success, columns numRows to numCols-1 hold the solutions as they do after calling GaussJordan.
+template<class T, size_t ROWS, size_t COLS> bool FixedMatrix<T, ROWS, COLS>::CholeskySolve(size_t numRows, size_t numCols) noexcept
+{
+	// Factorise the left hand part into L * L^T, storing L in the lower triangle
+	for (size_t j = 0; j < numRows; ++j)
+	{
+		T * const rowJ = data[j];
+		T diag = rowJ[j];
+		for (size_t k = 0; k < j; ++k)
+		{
+			diag -= rowJ[k] * rowJ[k];
+		}
+		if (!(diag > (T)0.0))
+		{
+			return false;
+		}
+		diag = std::sqrt(diag);
+		rowJ[j] = diag;
+
+		for (size_t i = j + 1; i < numRows; ++i)
+		{
+			T * const rowI = data[i];
+			rowI[j] = (rowI[j] - RowDotProduct(rowI, rowJ, j))/diag;
+		}
+	}
+
+	for (size_t c = numRows; c < numCols; ++c)
+	{
+		// Forward substitution to solve L * y = b
+		for (size_t i = 0; i < numRows; ++i)
+		{
+			const T * const row = data[i];
+			T sum = row[c];
+			for (size_t k = 0; k < i; ++k)
+			{
+				sum -= row[k] * data[k][c];
+			}
+			data[i][c] = sum/row[i];
+		}
+
+		// Back substitution to solve L^T * x = y
+		for (size_t i = numRows; i != 0; )
+		{
+			--i;
+			T sum = data[i][c];
+			for (size_t k = i + 1; k < numRows; ++k)
+			{
+				sum -= data[k][i] * data[k][c];
+			}
+			data[i][c] = sum/data[i][i];
+		}
+	}
+
+	return true;
+}
+
 // Set all elements to a specified value
 template<class T, size_t ROWS, size_t COLS>void FixedMatrix<T, ROWS, COLS>::Fill(T val) noexcept
 {
@@ -156,4 +355,69 @@ template<class T, size_t ROWS, size_t COLS>void FixedMatrix<T, ROWS, COLS>::Fill
 	}
 }
 
+// Class to accumulate the normal equations of a linear least squares fit, one point at a time, so that we don't need to store the whole set of points.
+// For each point, the caller supplies the derivatives of the fitted function with respect to each factor, and the value to be fitted.
+template<class T, size_t MaxFactors> class LeastSquaresAccumulator
+{
+public:
+	LeastSquaresAccumulator() noexcept : numFactors(0), numPoints(0) { }
+
+	// Start a new fit
+	void Init(size_t p_numFactors) noexcept
+	pre(p_numFactors <= MaxFactors)
+	;
+
+	// Add a point with an optional weight
+	void AddPoint(const T *derivatives, T value, T weight = (T)1.0) noexcept;
+
+	// Solve the normal equations using Cholesky decomposition, returning true if successful. This destroys the accumulated data.
+	bool Solve(T *solution) noexcept;
+
+	size_t GetNumFactors() const noexcept { return numFactors; }
+	size_t GetNumPoints() const noexcept { return numPoints; }
+
+	// Get the normal matrix. Only the elements on and below the diagonal are valid.
+	const FixedMatrix<T, MaxFactors, MaxFactors + 1>& GetNormalMatrix() const noexcept { return normalMatrix; }
+
+private:
+	FixedMatrix<T, MaxFactors, MaxFactors + 1> normalMatrix;			// the left hand part is A^T * A, the last column that we use is A^T * b
+	size_t numFactors;
+	size_t numPoints;
+};
+
+template<class T, size_t MaxFactors> void LeastSquaresAccumulator<T, MaxFactors>::Init(size_t p_numFactors) noexcept
+{
+	numFactors = p_numFactors;
+	numPoints = 0;
+	normalMatrix.Fill((T)0.0);
+}
+
+template<class T, size_t MaxFactors> void LeastSquaresAccumulator<T, MaxFactors>::AddPoint(const T *derivatives, T value, T weight) noexcept
+{
+	for (size_t i = 0; i < numFactors; ++i)
+	{
+		T * const row = normalMatrix.GetRow(i);
+		const T wd = weight * derivatives[i];
+		for (size_t j = 0; j <= i; ++j)
+		{
+			row[j] += wd * derivatives[j];
+		}
+		row[numFactors] += wd * value;
+	}
+	++numPoints;
+}
+
+template<class T, size_t MaxFactors> bool LeastSquaresAccumulator<T, MaxFactors>::Solve(T *solution) noexcept
+{
+	if (numFactors == 0 || !normalMatrix.CholeskySolve(numFactors, numFactors + 1))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < numFactors; ++i)
+	{
+		solution[i] = normalMatrix(i, numFactors);
+	}
+	return true;
+}
+
 #endif /* MATRIX_H_ */
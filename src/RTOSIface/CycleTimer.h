@@ -0,0 +1,115 @@
+/*
+ * CycleTimer.h
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  Classes to measure how many CPU cycles sections of code take, using the DWT cycle counter.
+ *  In host builds they measure nanoseconds instead.
+ */
+
+#ifndef SRC_RTOSIFACE_CYCLETIMER_H_
+#define SRC_RTOSIFACE_CYCLETIMER_H_
+
+#include "RTOSIface.h"
+
+#if !RRFLIBS_SAMC21
+
+// Class to accumulate timing statistics for a section of code that is executed repeatedly.
+// Call Start() before the code and Stop() after it. Sections longer than 2^32 cycles are not measured correctly.
+// There is no locking, so each instance must only be used by one task at a time.
+class CycleTimer
+{
+public:
+	CycleTimer() noexcept { EnableCycleCounter(); Clear(); }
+
+	void Clear() noexcept
+	{
+		numSamples = 0;
+		totalCycles = 0;
+		minCycles = 0xFFFFFFFF;
+		maxCycles = 0;
+	}
+
+	void Start() noexcept { startTime = GetCycleCount(); }
+
+	// Stop timing and record the sample, returning the number of cycles taken
+	uint32_t Stop() noexcept
+	{
+		const uint32_t cycles = GetCycleCount() - startTime;
+		Record(cycles);
+		return cycles;
+	}
+
+	// Record a sample measured by some other means, e.g. the total time for a loop divided by the number of iterations
+	void Record(uint32_t cycles) noexcept
+	{
+		++numSamples;
+		totalCycles += cycles;
+		if (cycles < minCycles) { minCycles = cycles; }
+		if (cycles > maxCycles) { maxCycles = cycles; }
+	}
+
+	uint32_t GetNumSamples() const noexcept { return numSamples; }
+	uint64_t GetTotalCycles() const noexcept { return totalCycles; }
+	uint32_t GetMinCycles() const noexcept { return (numSamples == 0) ? 0 : minCycles; }
+	uint32_t GetMaxCycles() const noexcept { return maxCycles; }
+	uint32_t GetMeanCycles() const noexcept { return (numSamples == 0) ? 0 : (uint32_t)(totalCycles/numSamples); }
+
+	// Convert a number of cycles to nanoseconds given the CPU clock frequency
+	static constexpr uint32_t CyclesToNanoseconds(uint32_t cycles, uint32_t cpuClockHz) noexcept
+	{
+		return (uint32_t)(((uint64_t)cycles * 1000000000u) / cpuClockHz);
+	}
+
+private:
+	uint64_t totalCycles;
+	uint32_t numSamples;
+	uint32_t minCycles;
+	uint32_t maxCycles;
+	uint32_t startTime;
+};
+
+// Measure the average number of cycles per call of a function or lambda that takes no arguments, by calling it 'iterations' times.
+// The overhead of an empty loop of the same length is subtracted, so that very short operations can be measured.
+template<class F> uint32_t MeasureCyclesPerCall(F func, uint32_t iterations) noexcept
+{
+	if (iterations == 0)
+	{
+		return 0;
+	}
+
+	EnableCycleCounter();
+	uint32_t startTime = GetCycleCount();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		__asm volatile("" : : : "memory");				// stop the compiler removing the empty loop
+	}
+	const uint32_t overhead = GetCycleCount() - startTime;
+
+	startTime = GetCycleCount();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		func();
+		__asm volatile("" : : : "memory");
+	}
+	const uint32_t total = GetCycleCount() - startTime;
+	return (total > overhead) ? (total - overhead)/iterations : 0;
+}
+
+// Class to time a scope, e.g. the body of a function, recording the result in a CycleTimer when it goes out of scope
+class CycleTimerScope
+{
+public:
+	explicit CycleTimerScope(CycleTimer& t) noexcept : timer(t) { timer.Start(); }
+	~CycleTimerScope() noexcept { (void)timer.Stop(); }
+
+	CycleTimerScope(const CycleTimerScope&) = delete;
+	CycleTimerScope& operator=(const CycleTimerScope&) = delete;
+
+private:
+	CycleTimer& timer;
+};
+
+#endif
+
+#endif /* SRC_RTOSIFACE_CYCLETIMER_H_ */
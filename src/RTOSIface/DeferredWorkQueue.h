@@ -0,0 +1,113 @@
+/*
+ * DeferredWorkQueue.h
+ *
+ *  Created on: 14 Oct 2026
+ *
+ *  A single task that runs functions posted to it by ISRs and other tasks
+ */
+
+#ifndef SRC_RTOSIFACE_DEFERREDWORKQUEUE_H_
+#define SRC_RTOSIFACE_DEFERREDWORKQUEUE_H_
+
+#include "RTOSIface.h"
+
+#ifdef RTOS
+
+#include "../General/MultiProducerRingBuffer.h"
+
+// Class to run deferred work, e.g. the follow-up processing for interrupts, in a single task instead of having a separate task for each subsystem.
+// Work items are a function pointer and an argument. They are posted with a priority in the range 0 to NumPriorities-1, higher numbers being more urgent.
+// The worker always runs the oldest item of the highest priority that is waiting. An item must not block for long, because that delays all the others.
+// QueueSize is the number of items that can be waiting at each priority, which must be a power of 2.
+// Posting is lock-free, using one MultiProducerRingBuffer per priority, so Post may be called from any task or ISR.
+template<unsigned int StackWords, size_t QueueSize, unsigned int NumPriorities = 2> class DeferredWorkQueue
+{
+public:
+	typedef void (*WorkFunction)(void *arg) noexcept;
+
+	DeferredWorkQueue() noexcept : numDropped(0) { }
+
+	// Create the worker task
+	void Start(const char *pName, unsigned int taskPriority) noexcept { task.Create(WorkerEntry, pName, this, taskPriority); }
+
+	// Post a work item, returning true if successful or false if the queue for that priority is full. May be called from any task or ISR.
+	bool Post(WorkFunction func, void *arg, unsigned int priority = 0) noexcept;
+
+	// Return the number of work items that could not be posted because the queue was full
+	uint32_t GetNumDropped() const noexcept { return numDropped; }
+
+	const TaskBase& GetTask() const noexcept { return task; }
+
+	static constexpr unsigned int GetNumPriorities() noexcept { return NumPriorities; }
+
+private:
+	struct WorkItem
+	{
+		WorkFunction func;
+		void *arg;
+	};
+
+	static_assert(NumPriorities != 0, "DeferredWorkQueue needs at least one priority");
+
+	static void WorkerEntry(void *param) noexcept { static_cast<DeferredWorkQueue *>(param)->Run(); }
+	[[noreturn]] void Run() noexcept;
+
+	Task<StackWords> task;
+	MultiProducerRingBuffer<WorkItem, QueueSize> queues[NumPriorities];
+	volatile uint32_t numDropped;
+};
+
+template<unsigned int StackWords, size_t QueueSize, unsigned int NumPriorities> bool DeferredWorkQueue<StackWords, QueueSize, NumPriorities>::Post(WorkFunction func, void *arg, unsigned int priority) noexcept
+{
+	if (priority >= NumPriorities)
+	{
+		priority = NumPriorities - 1;
+	}
+
+	const WorkItem item = { func, arg };
+	if (!queues[priority].PutItem(item))
+	{
+		const uint32_t primask = SaveAndDisableInterrupts();		// numDropped may be incremented from an ISR
+		++numDropped;
+		RestoreInterrupts(primask);
+		return false;
+	}
+
+	if (IsInInterrupt())
+	{
+		task.GiveFromISR();
+	}
+	else if (task.GetHandle() != nullptr)
+	{
+		task.Give();
+	}
+	return true;
+}
+
+template<unsigned int StackWords, size_t QueueSize, unsigned int NumPriorities> void DeferredWorkQueue<StackWords, QueueSize, NumPriorities>::Run() noexcept
+{
+	for (;;)
+	{
+		// Run the highest priority item. After running it, start looking again at the highest priority because more work may have been posted.
+		bool ranItem = false;
+		for (unsigned int priority = NumPriorities; priority != 0 && !ranItem; )
+		{
+			--priority;
+			WorkItem item;
+			if (queues[priority].GetItem(item))
+			{
+				item.func(item.arg);
+				ranItem = true;
+			}
+		}
+
+		if (!ranItem)
+		{
+			(void)TaskBase::Take();							// nothing to do, so wait until something is posted
+		}
+	}
+}
+
+#endif
+
+#endif /* SRC_RTOSIFACE_DEFERREDWORKQUEUE_H_ */
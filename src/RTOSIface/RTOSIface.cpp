@@ -12,6 +12,7 @@
 # include "FreeRTOS.h"
 # include "task.h"
 # include "semphr.h"
+# include "event_groups.h"
 # include <atomic>
 
 static_assert(Mutex::TimeoutUnlimited == portMAX_DELAY, "Bad value for TimeoutUnlimited");
@@ -21,6 +22,9 @@ void Mutex::Create(const char *pName) noexcept
 	if (handle == nullptr)
 	{
 		handle = xSemaphoreCreateRecursiveMutexStatic(&storage);
+#if RRFLIBS_LOCK_STATISTICS
+		EnableCycleCounter();
+#endif
 		name = pName;
 		next = mutexList;
 		mutexList = this;
@@ -30,13 +34,36 @@ void Mutex::Create(const char *pName) noexcept
 // Take ownership of a mutex returning true if successful
 bool Mutex::Take(uint32_t timeout) const noexcept
 {
+#if RRFLIBS_LOCK_STATISTICS
+	// Try to take the mutex without waiting first, so that we know whether it was contended
+	const uint32_t startTime = GetCycleCount();
+	bool contended = false;
+	if (xSemaphoreTakeRecursive(handle, 0) != pdTRUE)
+	{
+		if (timeout == 0 || xSemaphoreTakeRecursive(handle, timeout) != pdTRUE)
+		{
+			return false;
+		}
+		contended = true;
+	}
+	stats.RecordAcquisition(contended, startTime);
+	stats.RecordHoldStart();
+	return true;
+#else
 	return xSemaphoreTakeRecursive(handle, timeout) == pdTRUE;
+#endif
 }
 
 // Release a mutex returning true if successful.
 // Note that the return value does not indicate whether the mutex is still owned, because it may have been taken more than once.
 bool Mutex::Release() const noexcept
 {
+#if RRFLIBS_LOCK_STATISTICS
+	if (GetHolder() == RTOSIface::GetCurrentTask())
+	{
+		stats.RecordHoldEnd();
+	}
+#endif
 	return xSemaphoreGiveRecursive(handle) == pdTRUE;
 }
 
@@ -50,6 +77,59 @@ TaskBase::TaskId TaskBase::numTasks = 0;
 
 Mutex *Mutex::mutexList = nullptr;
 
+#if RRFLIBS_LOCK_STATISTICS
+
+ReadWriteLock *ReadWriteLock::lockList = nullptr;
+
+void LockStatistics::Clear() noexcept
+{
+	numAcquisitions = numContended = 0;
+	totalWaitCycles = 0;
+	maxWaitCycles = maxHoldCycles = 0;
+	lastContender = nullptr;
+}
+
+// Record that the lock has been acquired. Recursive acquisitions are counted too.
+void LockStatistics::RecordAcquisition(bool contended, uint32_t waitStartTime) noexcept
+{
+	++numAcquisitions;
+	if (contended)
+	{
+		const uint32_t waitTime = GetCycleCount() - waitStartTime;
+		++numContended;
+		totalWaitCycles += waitTime;
+		if (waitTime > maxWaitCycles)
+		{
+			maxWaitCycles = waitTime;
+		}
+		lastContender = RTOSIface::GetCurrentTask();
+	}
+}
+
+// Record that an exclusive lock has been acquired, so that we can time how long it is held for
+void LockStatistics::RecordHoldStart() noexcept
+{
+	if (nesting++ == 0)
+	{
+		holdStartTime = GetCycleCount();
+	}
+}
+
+// Record that an exclusive lock is being released
+void LockStatistics::RecordHoldEnd() noexcept
+{
+	if (nesting != 0 && --nesting == 0)
+	{
+		const uint32_t holdTime = GetCycleCount() - holdStartTime;
+		if (holdTime > maxHoldCycles)
+		{
+			maxHoldCycles = holdTime;
+		}
+	}
+}
+
+#endif
+
 #else
 
 void Mutex::Create(const char *pName) noexcept
@@ -148,7 +228,80 @@ bool BinarySemaphore::Give() const noexcept
 	return xSemaphoreGive(handle);
 }
 
+CountingSemaphore::CountingSemaphore(uint32_t maxCount, uint32_t initialCount) noexcept
+{
+	handle = xSemaphoreCreateCountingStatic(maxCount, initialCount, &storage);
+}
+
+bool CountingSemaphore::Take(uint32_t timeout) const noexcept
+{
+	return xSemaphoreTake(handle, timeout);
+}
+
+bool CountingSemaphore::Give() const noexcept
+{
+	return xSemaphoreGive(handle);
+}
+
+bool CountingSemaphore::GiveFromISR() const noexcept
+{
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	const bool ret = xSemaphoreGiveFromISR(handle, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+	return ret;
+}
+
+uint32_t CountingSemaphore::GetCount() const noexcept
+{
+	return uxSemaphoreGetCount(handle);
+}
+
+EventGroup::EventGroup() noexcept
+{
+	handle = xEventGroupCreateStatic(&storage);
+}
+
+EventGroup::Bits EventGroup::Set(Bits bits) const noexcept
+{
+	return xEventGroupSetBits(handle, bits);
+}
+
+// Set bits from an ISR. FreeRTOS defers the operation to the timer task, so this returns false if the timer command queue is full.
+bool EventGroup::SetFromISR(Bits bits) const noexcept
+{
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+	const bool ret = xEventGroupSetBitsFromISR(handle, bits, &higherPriorityTaskWoken) == pdPASS;
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+	return ret;
+}
+
+EventGroup::Bits EventGroup::Clear(Bits bits) const noexcept
+{
+	return xEventGroupClearBits(handle, bits);
+}
+
+EventGroup::Bits EventGroup::Get() const noexcept
+{
+	return xEventGroupGetBits(handle);
+}
+
+EventGroup::Bits EventGroup::GetFromISR() const noexcept
+{
+	return xEventGroupGetBitsFromISR(handle);
+}
+
+EventGroup::Bits EventGroup::WaitForAny(Bits bits, bool clearOnExit, uint32_t timeout) const noexcept
+{
+	return xEventGroupWaitBits(handle, bits, (clearOnExit) ? pdTRUE : pdFALSE, pdFALSE, timeout);
+}
+
+EventGroup::Bits EventGroup::WaitForAll(Bits bits, bool clearOnExit, uint32_t timeout) const noexcept
+{
+	return xEventGroupWaitBits(handle, bits, (clearOnExit) ? pdTRUE : pdFALSE, pdTRUE, timeout);
+}
+
 // Link the task into the thread list and allocate a short task ID to it. Task IDs start at 1.
+// If we can, also store the address of this object in a thread local storage pointer, so that GetCallerTask and GetCallerTaskId don't need to search the list.
 void TaskBase::AddToList() noexcept
 {
 	TaskCriticalSectionLocker lock;
@@ -158,26 +311,33 @@ void TaskBase::AddToList() noexcept
 	handle = &storage;
 	next = taskList;
 	taskList = this;
+#if RRFLIBS_TASKBASE_USE_TLS
+	vTaskSetThreadLocalStoragePointer(handle, TASKBASE_TLS_INDEX, this);
+#endif
 }
 
-// Get the short-form task ID
-/*static*/ TaskBase::TaskId TaskBase::GetCallerTaskId() noexcept
+#if !RRFLIBS_TASKBASE_USE_TLS
+
+// Get the TaskBase object of the calling task
+/*static*/ TaskBase *TaskBase::GetCallerTask() noexcept
 {
 	TaskHandle_t currentTaskHandle = xTaskGetCurrentTaskHandle();
 
-	// We need to get the task ID given the task handle.
+	// We need to find the task given the task handle.
 	// We could cheat and rely on the fact the the task ID should be 4 bytes before the storage that the task handle points to.
 	// But we'll do it properly and search the task list instead.
-	for (TaskBase** tpp = &taskList; *tpp != nullptr; tpp = &(*tpp)->next)
+	for (TaskBase* tp = taskList; tp != nullptr; tp = tp->next)
 	{
-		if ((*tpp)->handle == currentTaskHandle)
+		if (tp->handle == currentTaskHandle)
 		{
-			return (*tpp)->taskId;
+			return tp;
 		}
 	}
-	return 0;				// won't happen unless the current task hasn't been linked into the task list
+	return nullptr;			// won't happen unless the current task hasn't been linked into the task list
 }
 
+#endif
+
 // Terminate a task and remove it from the thread list
 void TaskBase::TerminateAndUnlink() noexcept
 {
@@ -222,6 +382,208 @@ namespace RTOSIface
 
 }
 
+#if defined(RTOS) && !RRFLIBS_SAMC21
+
+// Blocking version. Tasks that can't get the lock wait on the event group until the state changes.
+ReadWriteLock::ReadWriteLock() noexcept : numReaders(0), writing(false),
+#if RRFLIBS_LOCK_STATISTICS
+	next(nullptr), name(nullptr),
+#endif
+	writeLockOwner(nullptr)
+{
+	eventGroup.Set(NotWritingBit | NoReadersBit);
+#if RRFLIBS_LOCK_STATISTICS
+	EnableCycleCounter();
+	TaskCriticalSectionLocker lock;
+	next = lockList;
+	lockList = this;
+#endif
+}
+
+ReadWriteLock::ReadWriteLock(const char *pName) noexcept : ReadWriteLock()
+{
+#if RRFLIBS_LOCK_STATISTICS
+	name = pName;
+#endif
+}
+
+#if RRFLIBS_LOCK_STATISTICS
+
+ReadWriteLock::~ReadWriteLock() noexcept
+{
+	TaskCriticalSectionLocker lock;
+	for (ReadWriteLock** lpp = &lockList; *lpp != nullptr; lpp = &(*lpp)->next)
+	{
+		if (*lpp == this)
+		{
+			*lpp = next;
+			break;
+		}
+	}
+}
+
+void ReadWriteLock::ClearStatistics() noexcept
+{
+	TaskCriticalSectionLocker lock;
+	stats.Clear();
+}
+
+#endif
+
+void ReadWriteLock::LockForReading() noexcept
+{
+	if (writeLockOwner != TaskBase::GetCallerTaskHandle())
+	{
+#if RRFLIBS_LOCK_STATISTICS
+		const uint32_t startTime = GetCycleCount();
+		bool contended = false;
+#endif
+		for (;;)
+		{
+			bool writerActive;
+			{
+				TaskCriticalSectionLocker lock;
+				writerActive = writing;			// record why we can't have the lock, because writing may change as soon as we leave the critical section
+				if (!writerActive && numReaders < MaxReaders)
+				{
+					if (numReaders == 0)
+					{
+						eventGroup.Clear(NoReadersBit);
+					}
+					++numReaders;
+#if RRFLIBS_LOCK_STATISTICS
+					stats.RecordAcquisition(contended, startTime);
+#endif
+					break;
+				}
+			}
+
+#if RRFLIBS_LOCK_STATISTICS
+			contended = true;
+#endif
+
+			if (writerActive)
+			{
+				// Wait while writing is pending or active. If the writer has already released the lock then the bit is set and we try again immediately.
+				eventGroup.WaitForAll(NotWritingBit, false);
+			}
+			else
+			{
+				// There are MaxReaders readers already, which means that readers are not releasing the lock
+				configASSERT(false);
+				eventGroup.WaitForAll(NoReadersBit, false);
+			}
+		}
+	}
+}
+
+void ReadWriteLock::ReleaseReader() noexcept
+{
+	if (writeLockOwner != TaskBase::GetCallerTaskHandle())
+	{
+		TaskCriticalSectionLocker lock;
+		if (numReaders != 0)
+		{
+			--numReaders;
+			if (numReaders == 0)
+			{
+				eventGroup.Set(NoReadersBit);
+			}
+		}
+	}
+}
+
+void ReadWriteLock::LockForWriting() noexcept
+{
+#if RRFLIBS_LOCK_STATISTICS
+	const uint32_t startTime = GetCycleCount();
+	bool contended = false;
+#endif
+
+	// First wait for other writers to finish, then grab the write lock
+	for (;;)
+	{
+		{
+			TaskCriticalSectionLocker lock;
+			if (!writing)
+			{
+				writing = true;
+				eventGroup.Clear(NotWritingBit);
+				break;
+			}
+		}
+		eventGroup.WaitForAll(NotWritingBit, false);
+#if RRFLIBS_LOCK_STATISTICS
+		contended = true;
+#endif
+	}
+
+	// Now wait for readers to finish. No new readers can start while 'writing' is set.
+#if RRFLIBS_LOCK_STATISTICS
+	if ((eventGroup.Get() & NoReadersBit) == 0)
+	{
+		contended = true;
+	}
+#endif
+	eventGroup.WaitForAll(NoReadersBit, false);
+
+	writeLockOwner = TaskBase::GetCallerTaskHandle();
+#if RRFLIBS_LOCK_STATISTICS
+	TaskCriticalSectionLocker lock;
+	stats.RecordAcquisition(contended, startTime);
+	stats.RecordHoldStart();
+#endif
+}
+
+void ReadWriteLock::ReleaseWriter() noexcept
+{
+	if (writeLockOwner == TaskBase::GetCallerTaskHandle())
+	{
+		TaskCriticalSectionLocker lock;
+#if RRFLIBS_LOCK_STATISTICS
+		stats.RecordHoldEnd();
+#endif
+		writeLockOwner = nullptr;
+		writing = false;
+		eventGroup.Set(NotWritingBit);
+	}
+	else
+	{
+		// We must have downgraded to a read lock
+		ReleaseReader();
+	}
+}
+
+void ReadWriteLock::DowngradeWriter() noexcept
+{
+	if (writeLockOwner == TaskBase::GetCallerTaskHandle())
+	{
+		TaskCriticalSectionLocker lock;
+#if RRFLIBS_LOCK_STATISTICS
+		stats.RecordHoldEnd();
+#endif
+		numReaders = 1;
+		eventGroup.Clear(NoReadersBit);
+		writeLockOwner = nullptr;
+		writing = false;
+		eventGroup.Set(NotWritingBit);
+	}
+}
+
+#else
+
+// Polling version, used on the SAMC21 which can't do atomic operations, or when there is no RTOS
+ReadWriteLock::ReadWriteLock() noexcept
+#ifdef RTOS
+	: numReaders(0), writeLockOwner(nullptr)
+#endif
+{
+}
+
+ReadWriteLock::ReadWriteLock(const char *pName) noexcept : ReadWriteLock()
+{
+}
+
 void ReadWriteLock::LockForReading() noexcept
 {
 #ifdef RTOS
@@ -229,7 +591,6 @@ void ReadWriteLock::LockForReading() noexcept
 	{
 		for (;;)
 		{
-# if RRFLIBS_SAMC21
 			DisableInterrupts();
 			const uint8_t nr = numReaders;
 			if ((nr & 0x80) == 0)
@@ -240,17 +601,6 @@ void ReadWriteLock::LockForReading() noexcept
 			}
 			EnableInterrupts();
 			vTaskDelay(1);
-# else
-			uint8_t nr = numReaders;
-			if (nr & 0x80)
-			{
-				vTaskDelay(1);					// delay while writing is pending or active
-			}
-			else if (numReaders.compare_exchange_strong(nr, nr + 1))
-			{
-				break;
-			}
-# endif
 		}
 	}
 #endif
@@ -261,13 +611,9 @@ void ReadWriteLock::ReleaseReader() noexcept
 #ifdef RTOS
 	if (writeLockOwner != TaskBase::GetCallerTaskHandle())
 	{
-# if RRFLIBS_SAMC21
 		DisableInterrupts();
 		--numReaders;
 		EnableInterrupts();
-# else
-		--numReaders;
-# endif
 	}
 #endif
 }
@@ -278,7 +624,6 @@ void ReadWriteLock::LockForWriting() noexcept
 	// First wait for other writers to finish, then grab the write lock
 	for (;;)
 	{
-# if RRFLIBS_SAMC21
 		DisableInterrupts();
 		const uint8_t nr = numReaders;
 		if ((nr & 0x80) == 0)
@@ -289,17 +634,6 @@ void ReadWriteLock::LockForWriting() noexcept
 		}
 		EnableInterrupts();
 		vTaskDelay(1);
-# else
-		uint8_t nr = numReaders;
-		if (nr & 0x80)
-		{
-			vTaskDelay(1);					// delay while writing is pending or active
-		}
-		else if (numReaders.compare_exchange_strong(nr, nr | 0x80))
-		{
-			break;
-		}
-# endif
 	}
 
 	// Now wait for readers to finish
@@ -339,4 +673,6 @@ void ReadWriteLock::DowngradeWriter() noexcept
 #endif
 }
 
+#endif
+
 // End
@@ -17,10 +17,15 @@ typedef Task_undefined *TaskHandle;
 
 #include <utility>
 
+#ifndef __arm__
+# include <chrono>						// for the host version of GetCycleCount
+#endif
+
 #ifdef RTOS
 # include "FreeRTOS.h"
 # include "task.h"
 # include "semphr.h"
+# include "event_groups.h"
 # include <atomic>
 #endif
 
@@ -47,6 +52,192 @@ __attribute__( ( always_inline ) ) static inline void DisableInterrupts() noexce
   __asm volatile ("cpsid i" : : : "memory");
 }
 
+
+/** \brief  Disable IRQ Interrupts and save the previous state
+
+  This function saves the PRIMASK register and then disables IRQ interrupts. Use RestoreInterrupts to restore the saved state.
+  Unlike EnableInterrupts, this can be used when the caller may already have interrupts disabled, e.g. in an ISR.
+ */
+__attribute__( ( always_inline ) ) static inline uint32_t SaveAndDisableInterrupts() noexcept
+{
+  uint32_t primask;
+  __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) : : "memory");
+  return primask;
+}
+
+
+/** \brief  Restore IRQ Interrupts
+
+  This function restores the PRIMASK register to a value returned by SaveAndDisableInterrupts.
+ */
+__attribute__( ( always_inline ) ) static inline void RestoreInterrupts(uint32_t primask) noexcept
+{
+  __asm volatile ("msr primask, %0" : : "r" (primask) : "memory");
+}
+
+
+/** \brief  Test whether we are in an exception handler
+
+  This function returns true if the IPSR shows that an exception handler is executing.
+ */
+__attribute__( ( always_inline ) ) static inline bool IsInInterrupt() noexcept
+{
+  uint32_t ipsr;
+  __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+  return (ipsr & 0x1FF) != 0;
+}
+
+#if !RRFLIBS_SAMC21
+
+// Exclusive access primitives, used to build lock-free data structures on the Cortex-M3/M4/M7.
+// The reservation made by LoadExclusive is lost if another exclusive store to the same location is done, and also on any exception entry or return.
+// So if StoreExclusive succeeds, nothing else can have modified the location since the LoadExclusive, even if it was changed and then changed back.
+
+#ifdef __arm__
+
+// Load a word and mark the location for exclusive access
+__attribute__( ( always_inline ) ) static inline void *LoadExclusive(void * volatile *addr) noexcept
+{
+	void *rslt;
+	__asm volatile ("ldrex %0, %1" : "=r" (rslt) : "Q" (*addr) : "memory");
+	return rslt;
+}
+
+// Store a word if we still have exclusive access to the location, returning true if successful
+__attribute__( ( always_inline ) ) static inline bool StoreExclusive(void * volatile *addr, void *val) noexcept
+{
+	uint32_t failed;
+	__asm volatile ("strex %0, %2, %1" : "=&r" (failed), "=Q" (*addr) : "r" (val) : "memory");
+	return failed == 0;
+}
+
+// Load a 32-bit word and mark the location for exclusive access
+__attribute__( ( always_inline ) ) static inline uint32_t LoadExclusive(volatile uint32_t *addr) noexcept
+{
+	uint32_t rslt;
+	__asm volatile ("ldrex %0, %1" : "=r" (rslt) : "Q" (*addr) : "memory");
+	return rslt;
+}
+
+// Store a 32-bit word if we still have exclusive access to the location, returning true if successful
+__attribute__( ( always_inline ) ) static inline bool StoreExclusive(volatile uint32_t *addr, uint32_t val) noexcept
+{
+	uint32_t failed;
+	__asm volatile ("strex %0, %2, %1" : "=&r" (failed), "=Q" (*addr) : "r" (val) : "memory");
+	return failed == 0;
+}
+
+// Give up exclusive access without doing a store
+__attribute__( ( always_inline ) ) static inline void ClearExclusive() noexcept
+{
+	__asm volatile ("clrex" : : : "memory");
+}
+
+#else
+
+// Host builds (e.g. the benchmarks) don't have exclusive access instructions, so we emulate them using compare-and-swap.
+// StoreExclusive succeeds if the location still holds the value that LoadExclusive read. Unlike the real instructions this doesn't detect a change that was changed back,
+// so lock-free structures built on these functions are only safe in single-threaded host programs.
+static inline uintptr_t& ExclusiveReservation() noexcept
+{
+	static thread_local uintptr_t reservation;
+	return reservation;
+}
+
+static inline void *LoadExclusive(void * volatile *addr) noexcept
+{
+	void * const rslt = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+	ExclusiveReservation() = reinterpret_cast<uintptr_t>(rslt);
+	return rslt;
+}
+
+static inline bool StoreExclusive(void * volatile *addr, void *val) noexcept
+{
+	void *expected = reinterpret_cast<void *>(ExclusiveReservation());
+	return __atomic_compare_exchange_n(addr, &expected, val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t LoadExclusive(volatile uint32_t *addr) noexcept
+{
+	const uint32_t rslt = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+	ExclusiveReservation() = rslt;
+	return rslt;
+}
+
+static inline bool StoreExclusive(volatile uint32_t *addr, uint32_t val) noexcept
+{
+	uint32_t expected = (uint32_t)ExclusiveReservation();
+	return __atomic_compare_exchange_n(addr, &expected, val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void ClearExclusive() noexcept { }
+
+#endif
+
+#ifdef __arm__
+
+// Enable the cycle counter in the Data Watchpoint and Trace unit. It is harmless to call this more than once.
+__attribute__( ( always_inline ) ) static inline void EnableCycleCounter() noexcept
+{
+	*reinterpret_cast<volatile uint32_t *>(0xE000EDFC) |= 1u << 24;		// set TRCENA in DEMCR
+	*reinterpret_cast<volatile uint32_t *>(0xE0001000) |= 1u;				// set CYCCNTENA in DWT_CTRL
+}
+
+// Read the cycle counter
+__attribute__( ( always_inline ) ) static inline uint32_t GetCycleCount() noexcept
+{
+	return *reinterpret_cast<volatile uint32_t *>(0xE0001004);				// DWT_CYCCNT
+}
+
+#else
+
+// Host builds don't have a DWT, so the "cycle" count is the time from the monotonic clock in nanoseconds, truncated to 32 bits like the real counter
+static inline void EnableCycleCounter() noexcept { }
+
+static inline uint32_t GetCycleCount() noexcept
+{
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
+
+#endif
+
+// Define LOCK_STATISTICS as nonzero to make Mutex and ReadWriteLock record how often they are acquired, how often tasks have to wait for them, and for how long.
+// The times are measured in CPU cycles using the DWT cycle counter, so this isn't available on the SAMC21.
+#ifndef LOCK_STATISTICS
+# define LOCK_STATISTICS	0
+#endif
+
+#define RRFLIBS_LOCK_STATISTICS		(defined(RTOS) && LOCK_STATISTICS && !RRFLIBS_SAMC21)
+
+#if RRFLIBS_LOCK_STATISTICS
+
+// Usage statistics for a lock. They are only updated by a task that has acquired the lock, so they don't need to be updated atomically.
+// Attempts to acquire a lock that time out are not recorded.
+struct LockStatistics
+{
+	LockStatistics() noexcept : holdStartTime(0), nesting(0) { Clear(); }
+
+	void Clear() noexcept;
+	void RecordAcquisition(bool contended, uint32_t waitStartTime) noexcept;
+	void RecordHoldStart() noexcept;
+	void RecordHoldEnd() noexcept;
+
+	uint32_t numAcquisitions;			// number of times the lock was acquired
+	uint32_t numContended;				// number of times the lock was acquired after waiting for it
+	uint64_t totalWaitCycles;			// total time that tasks waited for the lock
+	uint32_t maxWaitCycles;				// longest time that a task waited for the lock
+	uint32_t maxHoldCycles;				// longest time that a task held the lock, for exclusive locks only
+	TaskHandle lastContender;			// the last task that had to wait for the lock
+
+private:
+	uint32_t holdStartTime;
+	uint32_t nesting;					// recursion count, for recursive locks
+};
+
+#endif
+
 class Mutex
 {
 public:
@@ -75,6 +266,11 @@ public:
 	static const Mutex *GetMutexList() noexcept { return mutexList; }
 #endif
 
+#if RRFLIBS_LOCK_STATISTICS
+	const LockStatistics& GetStatistics() const noexcept { return stats; }
+	void ClearStatistics() noexcept { stats.Clear(); }
+#endif
+
 private:
 
 #ifdef RTOS
@@ -82,6 +278,9 @@ private:
 	Mutex *next;
 	const char *name;
 	StaticSemaphore_t storage;
+# if RRFLIBS_LOCK_STATISTICS
+	mutable LockStatistics stats;
+# endif
 
 	static Mutex *mutexList;
 #else
@@ -108,7 +307,69 @@ private:
 #endif
 };
 
+class CountingSemaphore
+{
+public:
+	CountingSemaphore(uint32_t maxCount, uint32_t initialCount = 0) noexcept;
+
+	bool Take(uint32_t timeout = TimeoutUnlimited) const noexcept;
+	bool Give() const noexcept;
+	bool GiveFromISR() const noexcept;
+	uint32_t GetCount() const noexcept;
+
+	static constexpr uint32_t TimeoutUnlimited = 0xFFFFFFFF;
+
+private:
+
 #ifdef RTOS
+	SemaphoreHandle_t handle;
+	StaticSemaphore_t storage;
+#endif
+};
+
+// Class to let a task wait for any or all of several events with a single wakeup
+// Only the least significant 24 bits can be used.
+class EventGroup
+{
+public:
+	typedef uint32_t Bits;
+
+	EventGroup() noexcept;
+
+	Bits Set(Bits bits) const noexcept;						// set some bits, returning the bits that are now set
+	bool SetFromISR(Bits bits) const noexcept;				// set some bits from an ISR, returning true if successful
+	Bits Clear(Bits bits) const noexcept;					// clear some bits, returning the bits that were set before
+	Bits Get() const noexcept;
+	Bits GetFromISR() const noexcept;
+
+	// Wait until any or all of the specified bits are set or we time out, optionally clearing them. Return the bits that were set when we stopped waiting.
+	Bits WaitForAny(Bits bits, bool clearOnExit, uint32_t timeout = TimeoutUnlimited) const noexcept;
+	Bits WaitForAll(Bits bits, bool clearOnExit, uint32_t timeout = TimeoutUnlimited) const noexcept;
+
+	static constexpr Bits AllBits = 0x00FFFFFF;
+	static constexpr uint32_t TimeoutUnlimited = 0xFFFFFFFF;
+
+private:
+
+#ifdef RTOS
+	EventGroupHandle_t handle;
+	StaticEventGroup_t storage;
+#endif
+};
+
+#ifdef RTOS
+
+// Index of the FreeRTOS thread local storage pointer that we use to hold the address of the TaskBase object of each task
+#ifndef TASKBASE_TLS_INDEX
+# define TASKBASE_TLS_INDEX		0
+#endif
+
+// If FreeRTOS has been configured with enough thread local storage pointers then we use one of them to find the TaskBase of the calling task quickly, otherwise we search the task list
+#if defined(configNUM_THREAD_LOCAL_STORAGE_POINTERS) && configNUM_THREAD_LOCAL_STORAGE_POINTERS > TASKBASE_TLS_INDEX
+# define RRFLIBS_TASKBASE_USE_TLS	1
+#else
+# define RRFLIBS_TASKBASE_USE_TLS	0
+#endif
 
 class TaskBase
 {
@@ -118,7 +379,7 @@ public:
 	// This is used by the CAN subsystem, so that we can use 8-bit task IDs to identify a sending task, instead of needing to use 32-bits.
 	typedef uint32_t TaskId;
 
-	TaskBase() noexcept : handle(nullptr), next(nullptr), taskId(0) { }
+	TaskBase() noexcept : handle(nullptr), next(nullptr), context(nullptr), taskId(0) { }
 	~TaskBase() noexcept { TerminateAndUnlink(); }
 
 	// Get the short-form task ID. This is a small number, used to send a task ID in 1 byte or less i a CAN packet. It is guaranteed not to be zero.
@@ -170,7 +431,32 @@ public:
 
 	static TaskHandle GetCallerTaskHandle() noexcept { return (TaskHandle)xTaskGetCurrentTaskHandle(); }
 
-	static TaskId GetCallerTaskId() noexcept;
+	// Get the TaskBase object of the calling task, or nullptr if it hasn't been linked into the task list
+#if RRFLIBS_TASKBASE_USE_TLS
+	static TaskBase *GetCallerTask() noexcept
+	{
+		const TaskHandle_t h = xTaskGetCurrentTaskHandle();
+		return (h == nullptr) ? nullptr : static_cast<TaskBase*>(pvTaskGetThreadLocalStoragePointer(h, TASKBASE_TLS_INDEX));	// there is no current task until the scheduler has been started
+	}
+#else
+	static TaskBase *GetCallerTask() noexcept;
+#endif
+
+	// Get the short-form task ID of the calling task, or 0 if it hasn't been linked into the task list
+	static TaskId GetCallerTaskId() noexcept
+	{
+		const TaskBase * const t = GetCallerTask();
+		return (t != nullptr) ? t->taskId : 0;
+	}
+
+	// Per-task context pointer, for use by modules that keep per-task data
+	void *GetContext() const noexcept { return context; }
+	void SetContext(void *p) noexcept { context = p; }
+	static void *GetCallerContext() noexcept
+	{
+		const TaskBase * const t = GetCallerTask();
+		return (t != nullptr) ? t->context : nullptr;
+	}
 
 	TaskBase(const TaskBase&) = delete;				// it's not safe to copy these
 	TaskBase& operator=(const TaskBase&) = delete;	// it's not safe to assign these
@@ -189,6 +475,7 @@ public:
 protected:
 	TaskHandle_t handle;
 	TaskBase *next;
+	void *context;
 	TaskId taskId;
 	StaticTask_t storage;
 
@@ -328,14 +615,13 @@ public:
 // - Write locks are not recursive.
 // - If you have a write lock on an object, you can request a read lock on the same object and it will be granted automatically.
 // - If you have a read lock, you can't ask for a write lock on the same object, it will deadlock if you do.
+// On the SAMC21 a task that can't get the lock polls for it once per tick. On other processors it blocks on an event group until the lock is released,
+// and when several tasks are waiting they are woken in priority order.
 class ReadWriteLock
 {
 public:
-	ReadWriteLock() noexcept
-#ifdef RTOS
-		: numReaders(0), writeLockOwner(nullptr)
-#endif
-	{ }
+	ReadWriteLock() noexcept;
+	explicit ReadWriteLock(const char *pName) noexcept;	// the name is only used when lock statistics are enabled
 
 	void LockForReading() noexcept;
 	void ReleaseReader() noexcept;
@@ -343,14 +629,42 @@ public:
 	void ReleaseWriter() noexcept;
 	void DowngradeWriter() noexcept;					// turn a write lock into a read lock (but you can't go back again)
 
+	ReadWriteLock(const ReadWriteLock&) = delete;
+	ReadWriteLock& operator=(const ReadWriteLock&) = delete;
+
+#if RRFLIBS_LOCK_STATISTICS
+	// All ReadWriteLock objects are linked into a list so that their statistics can be reported
+	~ReadWriteLock() noexcept;
+
+	const ReadWriteLock *GetNext() const noexcept { return next; }
+	const char *GetName() const noexcept { return name; }
+	const LockStatistics& GetStatistics() const noexcept { return stats; }
+	void ClearStatistics() noexcept;
+
+	static const ReadWriteLock *GetLockList() noexcept { return lockList; }
+#endif
+
 private:
 
 #ifdef RTOS
 # if RRFLIBS_SAMC21
-	volatile uint8_t numReaders;			// SAMC21 doesn't support atomic operations, neither does the library
+	volatile uint8_t numReaders;			// SAMC21 doesn't support atomic operations, neither does the library. MSB is set if a task is writing or write pending.
 # else
-	std::atomic_uint8_t numReaders;			// MSB is set if a task is writing or write pending, lower bits are the number of readers
-	static_assert(std::atomic_uint8_t::is_always_lock_free);
+	// The state is only changed with the scheduler suspended, and the event group bits reflect the state so that waiting tasks can block until it changes
+	static constexpr EventGroup::Bits NotWritingBit = 1u << 0;		// set when no task is writing or waiting to write
+	static constexpr EventGroup::Bits NoReadersBit = 1u << 1;		// set when there are no readers
+	static constexpr uint16_t MaxReaders = 0xFFFF;
+
+	EventGroup eventGroup;
+	uint16_t numReaders;					// the number of readers
+	bool writing;							// true if a task is writing or write pending
+#  if RRFLIBS_LOCK_STATISTICS
+	ReadWriteLock *next;
+	const char *name;
+	LockStatistics stats;
+
+	static ReadWriteLock *lockList;
+#  endif
 # endif
 	volatile TaskHandle writeLockOwner;		// handle of the task that owns the write lock
 #endif